@@ -61,10 +61,13 @@ struct PACMAN_MESSAGE_STRUCT
     return get_timestamp();
   }
 
-  // FIX ME - implement this in the frame later
-  void set_first_timestamp(uint64_t /*ts*/) // NOLINT(build/unsigned)
+  // Only the header is set, for searching the latency buffer. The message holds whole seconds, so the
+  // timestamp is rounded down to the message it falls in.
+  void set_first_timestamp(uint64_t ts) // NOLINT(build/unsigned)
   {
-    // reinterpret_cast<dunedaq::detdataformats::pacman::PACMANFrame*>(&data)->set_timestamp(ts); // NOLINT
+    reinterpret_cast<dunedaq::detdataformats::pacman::PACMANFrame*>(&data) // NOLINT
+      ->get_msg_header((void*)&data)                                     // NOLINT
+      ->unix_ts = ts / 50000000;
   }
 
   uint64_t get_message_type() const // NOLINT(build/unsigned)
@@ -116,11 +119,17 @@ struct PACMAN_MESSAGE_STRUCT
     return reinterpret_cast<FrameType*>(data + PACMAN_FRAME_SIZE); // NOLINT
   }
 
-  size_t get_payload_size() { return PACMAN_FRAME_SIZE; }
+  // Only the message is relevant, not the whole array
+  size_t get_payload_size()
+  {
+    auto frame = reinterpret_cast<dunedaq::detdataformats::pacman::PACMANFrame*>(&data); // NOLINT
+    auto words = frame->get_msg_header((void*)&data)->words;                            // NOLINT
+    return reinterpret_cast<char*>(frame->get_msg_word((void*)&data, words)) - data;     // NOLINT
+  }
 
   size_t get_num_frames() { return 1; }
 
-  size_t get_frame_size() { return PACMAN_FRAME_SIZE; }
+  size_t get_frame_size() { return get_payload_size(); }
 
 
   static const constexpr daqdataformats::GeoID::SystemType system_type = daqdataformats::GeoID::SystemType::kNDLArTPC;
@@ -8,6 +8,8 @@
 #ifndef READOUT_INCLUDE_READOUT_CONCEPTS_LATENCYBUFFERCONCEPT_HPP_
 #define READOUT_INCLUDE_READOUT_CONCEPTS_LATENCYBUFFERCONCEPT_HPP_
 
+#include "opmonlib/InfoCollector.hpp"
+
 #include <nlohmann/json.hpp>
 
 #include <cstddef>
@@ -42,6 +44,21 @@ public:
   //! Move referenced object into LB
   virtual bool write(T&& element) = 0;
 
+  //! Move up to amount objects from the referenced array into LB, returns how many were written
+  virtual std::size_t write_n(T* elements, std::size_t amount) = 0;
+
+  //! Reserve up to amount contiguous slots for writing, returns how many were reserved.
+  //! The slots may still hold earlier elements, the caller has to overwrite the ones it commits.
+  //! Only the producer may call it, and only one reservation can be open.
+  virtual std::size_t reserve(T*& span, std::size_t amount) = 0;
+
+  //! Publish the first amount slots of the open reservation, the rest is given back.
+  //! Returns how many were published, LBs that copy on commit may run out of space.
+  virtual std::size_t commit(std::size_t amount) = 0;
+
+  //! Whether committed elements stay in the slots they were reserved in, rather than being copied
+  virtual bool commits_in_place() const { return true; }
+
   //! Move object from LB to referenced
   virtual bool read(T& element) = 0;
 
@@ -59,6 +76,9 @@ public:
 
   //! Flush all elements from the latency buffer
   virtual void flush() = 0;
+
+  //! Get info from the LB
+  virtual void get_info(opmonlib::InfoCollector& ci, int level) = 0;
 };
 
 } // namespace readout
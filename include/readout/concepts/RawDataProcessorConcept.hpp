@@ -11,6 +11,9 @@
 #include "opmonlib/InfoCollector.hpp"
 #include <nlohmann/json.hpp>
 
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <string>
 
 namespace dunedaq {
@@ -46,6 +49,19 @@ public:
   virtual void preprocess_item(ReadoutType* item) = 0;
   //! Postprocess one element
   virtual void postprocess_item(const ReadoutType* item) = 0;
+  //! Timestamp of the oldest element that is still being postprocessed, the latency buffer cleanup keeps it.
+  //! The maximum when there is none.
+  virtual std::uint64_t get_oldest_unprocessed_timestamp() // NOLINT(build/unsigned)
+  {
+    return std::numeric_limits<std::uint64_t>::max(); // NOLINT(build/unsigned)
+  }
+  //! Postprocess count contiguous elements
+  virtual void postprocess_items(const ReadoutType* items, std::size_t count)
+  {
+    for (std::size_t i = 0; i < count; ++i) {
+      postprocess_item(items + i);
+    }
+  }
 };
 
 } // namespace readout
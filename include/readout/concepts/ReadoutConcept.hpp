@@ -11,6 +11,8 @@
 
 #include "opmonlib/InfoCollector.hpp"
 
+#include <cstddef>
+
 namespace dunedaq {
 namespace readout {
 
@@ -18,7 +20,7 @@ class ReadoutConcept
 {
 public:
   ReadoutConcept() {}
-  ~ReadoutConcept() {}
+  virtual ~ReadoutConcept() {}
   ReadoutConcept(const ReadoutConcept&) = delete;            ///< ReadoutConcept is not copy-constructible
   ReadoutConcept& operator=(const ReadoutConcept&) = delete; ///< ReadoutConcept is not copy-assginable
   ReadoutConcept(ReadoutConcept&&) = delete;                 ///< ReadoutConcept is not move-constructible
@@ -38,6 +40,22 @@ public:
   virtual void run_timesync() = 0;
   //! Function that will be run in its own thread and consumes new incoming requests and handles them
   virtual void run_requests() = 0;
+
+  //! Grouped mode: start() does not run the consumer, request, timesync and cleanup threads of the link,
+  //! the shared threads of a ReadoutGroupModel drive it through the calls below instead
+  virtual void set_grouped(bool grouped) = 0;
+  //! Whether raw input is waiting to be consumed
+  virtual bool has_queued_input() = 0;
+  //! Consume a batch of the raw input that is already queued, without waiting. Returns the number consumed.
+  virtual size_t consume_queued() = 0;
+  //! Whether data requests are waiting to be issued
+  virtual bool has_queued_requests() = 0;
+  //! Issue the data requests that are already queued, without waiting. Returns the number issued.
+  virtual size_t issue_queued_requests() = 0;
+  //! Send a timesync message, and a fake trigger when enabled
+  virtual void send_timesync() = 0;
+  //! Clean up the latency buffer if needed
+  virtual void periodic_cleanup() = 0;
 };
 
 } // namespace readout
@@ -13,10 +13,12 @@
 #include "dfmessages/DataRequest.hpp"
 #include "opmonlib/InfoCollector.hpp"
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace dunedaq {
 namespace readout {
@@ -42,9 +44,21 @@ public:
 
   //! Check if cleanup is necessary and execute it if necessary
   virtual void cleanup_check() = 0;
+  //! When set, start() does not run the cleanup thread, periodic_cleanup() is called from outside instead
+  virtual void set_external_cleanup(bool external) = 0;
+  //! One pass of the periodic housekeeping: cleanup check
+  virtual void periodic_cleanup() = 0;
+  //! Cleanup keeps the elements from the timestamp returned by barrier on, e.g. the ones still being postprocessed
+  virtual void set_cleanup_barrier(std::function<uint64_t()> barrier) = 0; // NOLINT(build/unsigned)
   //! Issue a data request to the request handler
   virtual void issue_request(dfmessages::DataRequest /*dr*/,
                              appfwk::DAQSink<std::unique_ptr<daqdataformats::Fragment>>& /*fragment_queue*/) = 0;
+  //! Issue data requests together, they are served with a single traversal of the latency buffer
+  virtual void issue_requests(
+    std::vector<std::pair<dfmessages::DataRequest, appfwk::DAQSink<std::unique_ptr<daqdataformats::Fragment>>*>>
+      requests) = 0;
+  //! Newest timestamp written to the latency buffer, lets waiting requests be served right away
+  virtual void notify_newest_timestamp(uint64_t /*timestamp*/) = 0; // NOLINT(build/unsigned)
 
 protected:
   // Result code of requests
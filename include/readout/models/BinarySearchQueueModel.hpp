@@ -15,6 +15,9 @@
 
 #include "IterableQueueModel.hpp"
 
+#include <algorithm>
+#include <vector>
+
 namespace dunedaq {
 namespace readout {
 
@@ -22,13 +25,52 @@ template<class T>
 class BinarySearchQueueModel : public IterableQueueModel<T>
 {
 public:
+  // One timestamp is kept in the side index for every s_index_stride slots
+  static constexpr uint32_t s_index_stride = 16; // NOLINT(build/unsigned)
+
   BinarySearchQueueModel()
     : IterableQueueModel<T>()
-  {}
+  {
+    resize_index();
+  }
 
   explicit BinarySearchQueueModel(uint32_t size) // NOLINT(build/unsigned)
     : IterableQueueModel<T>(size)
-  {}
+  {
+    resize_index();
+  }
+
+  void conf(const nlohmann::json& cfg) override
+  {
+    IterableQueueModel<T>::conf(cfg);
+    resize_index();
+  }
+
+  bool write(T&& record) override
+  {
+    // The slot at writeIndex_ is never readable, so its index entry can be updated before publishing it
+    index_slot(IterableQueueModel<T>::writeIndex_.load(std::memory_order_relaxed), record);
+    return IterableQueueModel<T>::write(std::move(record));
+  }
+
+  std::size_t write_n(T* records, std::size_t n) override
+  {
+    auto const current_write = IterableQueueModel<T>::writeIndex_.load(std::memory_order_relaxed);
+    std::size_t amount = std::min(n, IterableQueueModel<T>::free_slots());
+    for (std::size_t i = 0; i < amount; ++i) {
+      index_slot((current_write + i) % IterableQueueModel<T>::size_, records[i]);
+    }
+    return IterableQueueModel<T>::write_n(records, n);
+  }
+
+  std::size_t commit(std::size_t n) override
+  {
+    auto const current_write = IterableQueueModel<T>::writeIndex_.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < n; ++i) {
+      index_slot(current_write + i, IterableQueueModel<T>::records_[current_write + i]);
+    }
+    return IterableQueueModel<T>::commit(n);
+  }
 
   typename IterableQueueModel<T>::Iterator lower_bound(T& element, bool /*with_errors=false*/)
   {
@@ -50,6 +92,8 @@ public:
       return IterableQueueModel<T>::end();
     }
 
+    narrow_with_index(element.get_first_timestamp(), start_index, end_index);
+
     while (true) {
       unsigned int diff =
         start_index <= end_index ? end_index - start_index : IterableQueueModel<T>::size_ + end_index - start_index;
@@ -66,6 +110,69 @@ public:
       }
     }
   }
+
+protected:
+  void resize_index()
+  {
+    m_timestamp_index.assign((IterableQueueModel<T>::size_ + s_index_stride - 1) / s_index_stride, 0);
+  }
+
+  void index_slot(uint32_t slot, const T& record) // NOLINT(build/unsigned)
+  {
+    if (slot % s_index_stride == 0) {
+      m_timestamp_index[slot / s_index_stride] = record.get_first_timestamp();
+    }
+  }
+
+  // Shrink the inclusive [start_index, end_index] slot range to at most s_index_stride slots
+  // by searching the dense timestamp index instead of the records themselves
+  void narrow_with_index(uint64_t timestamp,           // NOLINT(build/unsigned)
+                         unsigned int& start_index,    // NOLINT(build/unsigned)
+                         unsigned int& end_index) const // NOLINT(build/unsigned)
+  {
+    const unsigned int size = IterableQueueModel<T>::size_; // NOLINT(build/unsigned)
+    const unsigned int occupancy =                          // NOLINT(build/unsigned)
+      (start_index <= end_index ? end_index - start_index : size + end_index - start_index) + 1;
+
+    // Index entries covering readable slots, in logical order: [first_a, last_a] then [0, last_b]
+    const bool wraps = start_index > end_index;
+    const std::size_t first_a = (start_index + s_index_stride - 1) / s_index_stride;
+    const std::size_t last_a = (wraps ? size - 1 : end_index) / s_index_stride;
+    const std::size_t last_b = end_index / s_index_stride;
+
+    auto first_idx = m_timestamp_index.begin();
+    auto found = first_idx; // last entry with timestamp <= target
+    bool have_entry = false;
+    if (wraps && m_timestamp_index[0] <= timestamp) {
+      found = std::upper_bound(first_idx, first_idx + last_b + 1, timestamp) - 1;
+      have_entry = true;
+    } else if (first_a <= last_a && m_timestamp_index[first_a] <= timestamp) {
+      found = std::upper_bound(first_idx + first_a, first_idx + last_a + 1, timestamp) - 1;
+      have_entry = true;
+    }
+
+    unsigned int lo = 0; // NOLINT(build/unsigned)
+    unsigned int hi;     // NOLINT(build/unsigned)
+    if (have_entry) {
+      unsigned int slot = (found - first_idx) * s_index_stride; // NOLINT(build/unsigned)
+      lo = slot >= start_index ? slot - start_index : size + slot - start_index;
+      hi = std::min(lo + s_index_stride - 1, occupancy - 1);
+    } else {
+      // Target precedes the first indexed slot: it lies in the head before it
+      unsigned int first_slot = wraps && first_a > last_a ? 0 : first_a * s_index_stride; // NOLINT(build/unsigned)
+      unsigned int head = first_slot >= start_index ? first_slot - start_index : size + first_slot - start_index; // NOLINT(build/unsigned)
+      hi = std::min(head, occupancy) - (head > 0 ? 1 : 0);
+    }
+
+    end_index = start_index + hi;
+    if (end_index >= size)
+      end_index -= size;
+    start_index += lo;
+    if (start_index >= size)
+      start_index -= size;
+  }
+
+  std::vector<uint64_t> m_timestamp_index; // NOLINT(build/unsigned)
 };
 
 } // namespace readout
@@ -12,7 +12,11 @@
 #include "readout/ReadoutIssues.hpp"
 #include "readout/concepts/RequestHandlerConcept.hpp"
 #include "readout/utils/BufferedFileWriter.hpp"
+#include "readout/utils/FragmentBufferPool.hpp"
+#include "readout/utils/FragmentLease.hpp"
+#include "readout/utils/LatencyHistogram.hpp"
 #include "readout/utils/ReusableThread.hpp"
+#include "readout/utils/ThreadAffinity.hpp"
 
 #include "readout/readoutconfig/Nljs.hpp"
 
@@ -31,6 +35,7 @@
 #include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <deque>
 #include <functional>
 #include <future>
@@ -38,9 +43,12 @@
 #include <limits>
 #include <map>
 #include <memory>
+#include <optional>
 #include <queue>
 #include <string>
 #include <thread>
+#include <tuple>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -58,10 +66,9 @@ public:
   explicit DefaultRequestHandlerModel(std::unique_ptr<LatencyBufferType>& latency_buffer,
                                       std::unique_ptr<FrameErrorRegistry>& error_registry)
     : m_latency_buffer(latency_buffer)
-    , m_recording_thread(0)
-    , m_cleanup_thread(0)
     , m_waiting_requests()
     , m_waiting_requests_lock()
+    , m_waiting_cv()
     , m_error_registry(error_registry)
     , m_pop_limit_pct(0.0f)
     , m_pop_size_pct(0.0f)
@@ -80,19 +87,48 @@ public:
   using RequestResult = typename dunedaq::readout::RequestHandlerConcept<ReadoutType, LatencyBufferType>::RequestResult;
   using ResultCode = typename dunedaq::readout::RequestHandlerConcept<ReadoutType, LatencyBufferType>::ResultCode;
 
+  using request_clock = std::chrono::steady_clock;
+  using fragment_sink_t = appfwk::DAQSink<std::unique_ptr<daqdataformats::Fragment>>;
+
+  // A response on its way to a fragment sink
+  struct PendingResponse
+  {
+    explicit PendingResponse(std::unique_ptr<daqdataformats::Fragment> frag)
+      : fragment(std::move(frag))
+    {}
+
+    std::unique_ptr<daqdataformats::Fragment> fragment;
+    request_clock::time_point queued;
+    request_clock::time_point deadline;
+  };
+
+  // A request being served, with the pieces found for it so far
+  struct RequestTarget
+  {
+    RequestTarget(const dfmessages::DataRequest& data_request, const daqdataformats::FragmentHeader& fragment_header)
+      : request(data_request)
+      , header(fragment_header)
+    {}
+
+    dfmessages::DataRequest request;
+    daqdataformats::FragmentHeader header;
+    FragmentLease::pieces_t pieces;
+    ResultCode result_code = ResultCode::kUnknown;
+  };
+
   struct RequestElement
   {
     RequestElement(dfmessages::DataRequest data_request,
                    appfwk::DAQSink<std::unique_ptr<daqdataformats::Fragment>>* sink,
-                   size_t retries)
+                   request_clock::time_point request_deadline)
       : request(data_request)
       , fragment_sink(sink)
-      , retry_count(retries)
+      , deadline(request_deadline)
     {}
 
     dfmessages::DataRequest request;
     appfwk::DAQSink<std::unique_ptr<daqdataformats::Fragment>>* fragment_sink;
-    size_t retry_count;
+    request_clock::time_point deadline;
   };
 
   void init(const nlohmann::json& /*args*/) override {}
@@ -104,13 +140,26 @@ public:
     m_pop_size_pct = conf.pop_size_pct;
     m_buffer_capacity = conf.latency_buffer_size;
     m_num_request_handling_threads = conf.num_request_handling_threads;
-    m_retry_count = conf.retry_count;
+    // Without an explicit timeout, keep the time the former 10 ms rechecks used to give a request
+    m_request_timeout = std::chrono::milliseconds(
+      conf.request_timeout_ms != 0 ? conf.request_timeout_ms : conf.retry_count * s_legacy_retry_period_ms);
     m_fragment_queue_timeout = conf.fragment_queue_timeout_ms;
     m_output_file = conf.output_file;
     m_geoid.element_id = conf.element_id;
     m_geoid.region_id = conf.region_id;
     m_geoid.system_type = ReadoutType::system_type;
     m_stream_buffer_size = conf.stream_buffer_size;
+    m_lease_fragments = conf.lease_fragments;
+    m_retention_ticks = static_cast<uint64_t>(conf.retention_time_ms) * conf.clock_frequency_hz / 1000; // NOLINT
+    m_fragment_buffer_pool.set_depth(conf.fragment_buffer_pool_depth);
+    m_fragment_buffer_pool.set_capacity(conf.fragment_buffer_pool_bytes);
+    // One reader slot per request handling thread and the recording thread, followed by the lease slots
+    m_num_reader_slots = m_num_request_handling_threads + 1;
+    m_num_lease_slots = m_lease_fragments ? s_max_fragment_leases : 0;
+    m_reader_timestamps.reset(new std::atomic<uint64_t>[m_num_reader_slots + m_num_lease_slots]); // NOLINT
+    for (size_t i = 0; i < m_num_reader_slots + m_num_lease_slots; ++i) {
+      m_reader_timestamps[i].store(s_no_reader);
+    }
     // if (m_configured) {
     //  ers::error(ConfigurationError(ERS_HERE, "This object is already configured!"));
     if (m_pop_limit_pct < 0.0f || m_pop_limit_pct > 1.0f || m_pop_size_pct < 0.0f || m_pop_size_pct > 1.0f) {
@@ -130,8 +179,27 @@ public:
       m_recording_configured = true;
     }
 
-    m_recording_thread.set_name("recording", conf.element_id);
-    m_cleanup_thread.set_name("cleanup", conf.element_id);
+    auto affinity = args["threadaffinityconf"].get<readoutconfig::ThreadAffinityConf>();
+    m_request_cpus = resolve_cpus(affinity.request_cpus, affinity.cpus, affinity.numa_node);
+    m_housekeeping_cpus = resolve_cpus(affinity.housekeeping_cpus, affinity.cpus, affinity.numa_node);
+    // With external cleanup the caller does the housekeeping, no thread is started for it
+    if (!m_external_cleanup) {
+      if (m_cleanup_thread == nullptr) {
+        m_cleanup_thread = std::make_unique<ReusableThread>(0);
+      }
+      m_cleanup_thread->set_name("cleanup", conf.element_id);
+      if (!m_cleanup_thread->set_affinity(m_housekeeping_cpus)) {
+        ers::warning(ConfigurationError(ERS_HERE, m_geoid, "Could not set the CPU affinity of the cleanup thread"));
+      }
+    }
+    // The fragment buffers are allocated away from the request threads, whenever the CPU is idle
+    if (m_fragment_buffer_pool.get_depth() != 0 && m_refill_thread == nullptr) {
+      m_refill_thread = std::make_unique<ReusableThread>(0);
+      m_refill_thread->set_name("refill", conf.element_id);
+      if (!m_refill_thread->set_affinity(m_housekeeping_cpus) || !m_refill_thread->set_idle_priority()) {
+        ers::warning(ConfigurationError(ERS_HERE, m_geoid, "Could not place the fragment buffer refill thread"));
+      }
+    }
 
     std::ostringstream oss;
     oss << "RequestHandler configured. " << std::fixed << std::setprecision(2)
@@ -153,6 +221,10 @@ public:
     m_num_requests_timed_out = 0;
     m_handled_requests = 0;
     m_response_time_acc = 0;
+    m_queue_wait_histogram.reset();
+    m_buffer_search_histogram.reset();
+    m_fragment_build_histogram.reset();
+    m_sink_push_histogram.reset();
     m_pop_reqs = 0;
     m_pops_count = 0;
     m_payloads_written = 0;
@@ -160,25 +232,46 @@ public:
     m_t0 = std::chrono::high_resolution_clock::now();
 
     m_request_handler_thread_pool = std::make_unique<boost::asio::thread_pool>(m_num_request_handling_threads);
+    place_request_pool();
 
     m_run_marker.store(true);
-    m_cleanup_thread.set_work(&DefaultRequestHandlerModel<ReadoutType, LatencyBufferType>::periodic_cleanups, this);
-    m_waiting_queue_thread =
-      std::thread(&DefaultRequestHandlerModel<ReadoutType, LatencyBufferType>::check_waiting_requests, this);
+    m_completing_responses.store(true);
+    m_completion_thread = std::thread([this]() {
+      place_request_thread();
+      complete_responses();
+    });
+    if (!m_external_cleanup) {
+      m_cleanup_thread->set_work(&DefaultRequestHandlerModel<ReadoutType, LatencyBufferType>::periodic_cleanups, this);
+    }
+    if (m_refill_thread != nullptr && m_fragment_buffer_pool.get_depth() != 0) {
+      m_refill_thread->set_work(&DefaultRequestHandlerModel<ReadoutType, LatencyBufferType>::refill_fragment_buffers,
+                                this);
+    }
+    m_waiting_queue_thread = std::thread([this]() {
+      place_request_thread();
+      check_waiting_requests();
+    });
   }
 
   void stop(const nlohmann::json& /*args*/)
   {
     m_run_marker.store(false);
+    wake_waiting_requests();
     // if (m_recording) throw CommandError(ERS_HERE, "Recording is still ongoing!");
-    while (!m_recording_thread.get_readiness()) {
+    while (m_recording_thread != nullptr && !m_recording_thread->get_readiness()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    while (m_cleanup_thread != nullptr && !m_cleanup_thread->get_readiness()) {
       std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
-    while (!m_cleanup_thread.get_readiness()) {
+    while (m_refill_thread != nullptr && !m_refill_thread->get_readiness()) {
       std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
     m_waiting_queue_thread.join();
     m_request_handler_thread_pool->join();
+    m_completing_responses.store(false);
+    m_pending_responses_cv.notify_all();
+    m_completion_thread.join();
   }
 
   void record(const nlohmann::json& args) override
@@ -191,50 +284,55 @@ public:
       ers::error(CommandError(ERS_HERE, m_geoid, "DLH is not configured for recording"));
       return;
     }
-    m_recording_thread.set_work(
+    recording_thread().set_work(
       [&](int duration) {
         TLOG() << "Start recording for " << duration << " second(s)" << std::endl;
         m_recording.exchange(true);
         auto start_of_recording = std::chrono::high_resolution_clock::now();
         auto current_time = start_of_recording;
         m_next_timestamp_to_record = 0;
+        // Types without a fixed tick can have several elements with the same timestamp. The next timestamp
+        // to record is then the one of the last recorded element, and that many elements with it were written.
+        size_t recorded_at_next = 0;
         ReadoutType element_to_search;
         while (std::chrono::duration_cast<std::chrono::seconds>(current_time - start_of_recording).count() < duration) {
-          if (!m_cleanup_requested || (m_next_timestamp_to_record == 0)) {
+          {
+            auto reader_slot = enter_reader(m_next_timestamp_to_record);
             if (m_next_timestamp_to_record == 0) {
               auto front = m_latency_buffer->front();
               m_next_timestamp_to_record = front == nullptr ? 0 : front->get_first_timestamp();
+              recorded_at_next = 0;
             }
             element_to_search.set_first_timestamp(m_next_timestamp_to_record);
             size_t processed_chunks_in_loop = 0;
+            size_t to_skip = recorded_at_next;
 
-            {
-              std::unique_lock<std::mutex> lock(m_cv_mutex);
-              m_cv.wait(lock, [&] { return !m_cleanup_requested; });
-              m_requests_running++;
-            }
-            m_cv.notify_all();
             auto chunk_iter = m_latency_buffer->lower_bound(element_to_search, true);
             auto end = m_latency_buffer->end();
-            {
-              std::lock_guard<std::mutex> lock(m_cv_mutex);
-              m_requests_running--;
-            }
-            m_cv.notify_all();
-
-            for (; chunk_iter != end && chunk_iter.good() && processed_chunks_in_loop < 1000;) {
-              if ((*chunk_iter).get_first_timestamp() >= m_next_timestamp_to_record) {
-                if (!m_buffered_writer.write(reinterpret_cast<char*>(chunk_iter->begin()), // NOLINT 
-                                             chunk_iter->get_payload_size())) {
-                  ers::warning(CannotWriteToFile(ERS_HERE, m_output_file));
-                }
-                m_payloads_written++;
-                processed_chunks_in_loop++;
-                m_next_timestamp_to_record = (*chunk_iter).get_first_timestamp() +
-                                             ReadoutType::expected_tick_difference * (*chunk_iter).get_num_frames();
+            for (; chunk_iter != end && chunk_iter.good() && processed_chunks_in_loop < 1000; ++chunk_iter) {
+              uint64_t timestamp = (*chunk_iter).get_first_timestamp(); // NOLINT(build/unsigned)
+              if (timestamp < m_next_timestamp_to_record) {
+                continue;
+              }
+              if (timestamp == m_next_timestamp_to_record && to_skip > 0) {
+                --to_skip;
+                continue;
+              }
+              if (!m_buffered_writer.write(reinterpret_cast<char*>(chunk_iter->begin()), // NOLINT
+                                           chunk_iter->get_payload_size())) {
+                ers::warning(CannotWriteToFile(ERS_HERE, m_output_file));
+              }
+              m_payloads_written++;
+              processed_chunks_in_loop++;
+              if constexpr (ReadoutType::expected_tick_difference == 0) {
+                recorded_at_next = timestamp == m_next_timestamp_to_record ? recorded_at_next + 1 : 1;
+                m_next_timestamp_to_record = timestamp;
+              } else {
+                m_next_timestamp_to_record =
+                  timestamp + ReadoutType::expected_tick_difference * (*chunk_iter).get_num_frames();
               }
-              ++chunk_iter;
             }
+            exit_reader(reader_slot);
           }
           current_time = std::chrono::high_resolution_clock::now();
         }
@@ -249,59 +347,126 @@ public:
 
   void cleanup_check() override
   {
-    std::unique_lock<std::mutex> lock(m_cv_mutex);
-    if (m_latency_buffer->occupancy() > m_pop_limit_size && !m_cleanup_requested.exchange(true)) {
-      m_cv.wait(lock, [&] { return m_requests_running == 0; });
+    if (m_retention_ticks != 0 || m_latency_buffer->occupancy() > m_pop_limit_size) {
       cleanup();
-      m_cleanup_requested = false;
-      m_cv.notify_all();
     }
   }
 
+  void set_external_cleanup(bool external) override { m_external_cleanup = external; }
+
+  void set_cleanup_barrier(std::function<uint64_t()> barrier) override // NOLINT(build/unsigned)
+  {
+    m_cleanup_barrier = std::move(barrier);
+  }
+
+  void periodic_cleanup() override { cleanup_check(); }
+
   void issue_request(dfmessages::DataRequest datarequest,
                      appfwk::DAQSink<std::unique_ptr<daqdataformats::Fragment>>& fragment_queue) override
   {
-    boost::asio::post(*m_request_handler_thread_pool, [&, datarequest]() { // start a thread from pool
-      auto t_req_begin = std::chrono::high_resolution_clock::now();
-      {
-        std::unique_lock<std::mutex> lock(m_cv_mutex);
-        m_cv.wait(lock, [&] { return !m_cleanup_requested; });
-        m_requests_running++;
+    issue_requests({ std::make_pair(datarequest, &fragment_queue) });
+  }
+
+  // Requests are served oldest window first: that data is the closest to being cleaned up
+  void issue_requests(std::vector<std::pair<dfmessages::DataRequest, fragment_sink_t*>> requests) override
+  {
+    {
+      std::lock_guard<std::mutex> lock_guard(m_scheduled_requests_lock);
+      uint64_t oldest_window_begin = std::numeric_limits<uint64_t>::max(); // NOLINT(build/unsigned)
+      for (auto& request : requests) {
+        oldest_window_begin = std::min(oldest_window_begin, request.first.window_begin);
+      }
+      m_scheduled_requests.emplace(oldest_window_begin, m_next_scheduled_id, request_clock::now(), std::move(requests));
+      m_next_scheduled_id++;
+    }
+    // Every task serves whatever is the most urgent once a thread of the pool picks it up
+    boost::asio::post(*m_request_handler_thread_pool, [&]() { // start a thread from pool
+      std::unique_lock<std::mutex> lock(m_scheduled_requests_lock);
+      auto queued = std::get<2>(m_scheduled_requests.top());
+      auto requests = std::get<3>(m_scheduled_requests.top());
+      m_scheduled_requests.pop();
+      lock.unlock();
+      m_queue_wait_histogram.record(elapsed_ns(queued), requests.size());
+      serve_requests(requests);
+    });
+  }
+
+  void serve_requests(const std::vector<std::pair<dfmessages::DataRequest, fragment_sink_t*>>& requests)
+  {
+    auto t_req_begin = std::chrono::high_resolution_clock::now();
+    std::vector<RequestTarget> targets;
+    uint64_t oldest_window_begin = std::numeric_limits<uint64_t>::max(); // NOLINT(build/unsigned)
+    for (auto& request : requests) {
+      targets.emplace_back(request.first, create_fragment_header(request.first));
+      oldest_window_begin = std::min(oldest_window_begin, request.first.window_begin);
+    }
+    // Nothing before the element covering the oldest window begin is read while the request is served
+    auto reader_slot = enter_reader(oldest_window_begin);
+
+    auto search_begin = request_clock::now();
+    find_fragment_pieces(targets);
+    m_buffer_search_histogram.record(elapsed_ns(search_begin), targets.size());
+
+    // Leases outlive the request, they keep the data with a lease slot of their own. The slot is given
+    // back once the last lease on the found pieces is copied. When all slots are held by earlier copies,
+    // the fragments are copied here instead of waiting for one.
+    std::optional<size_t> lease_slot;
+    if (m_lease_fragments) {
+      lease_slot = try_enter_lease(oldest_window_begin);
+      if (!lease_slot) {
+        ++m_num_lease_fallbacks;
       }
-      m_cv.notify_all();
-      auto result = data_request(datarequest);
-      {
-        std::lock_guard<std::mutex> lock(m_cv_mutex);
-        m_requests_running--;
+    }
+    std::shared_ptr<void> lease_pin(nullptr, [this, lease_slot](void*) {
+      if (lease_slot) {
+        exit_reader(*lease_slot);
       }
-      m_cv.notify_all();
-      if (result.result_code == ResultCode::kFound || result.result_code == ResultCode::kNotFound) {
-        try { // Push to Fragment queue
-          TLOG_DEBUG(TLVL_QUEUE_PUSH) << "Sending fragment with trigger_number "
-                                      << result.fragment->get_trigger_number() << ", run number "
-                                      << result.fragment->get_run_number() << ", and GeoID "
-                                      << result.fragment->get_element_id();
-          fragment_queue.push(std::move(result.fragment), std::chrono::milliseconds(m_fragment_queue_timeout));
-        } catch (const ers::Issue& excpt) {
-          ers::warning(CannotWriteToQueue(ERS_HERE, m_geoid, "fragment queue"));
+    });
+
+    for (size_t i = 0; i < targets.size(); ++i) {
+      auto& target = targets[i];
+      auto& fragment_queue = *requests[i].second;
+      if (target.result_code == ResultCode::kFound || target.result_code == ResultCode::kNotFound) {
+        // The pieces stay valid until the lease is given back
+        FragmentLease lease(target.header, std::move(target.pieces), [lease_pin]() mutable { lease_pin.reset(); });
+        if (lease_slot) {
+          // The copies of a request group run side by side on the pool, each lease is given back
+          // as soon as its copy is done
+          auto leased = std::make_shared<FragmentLease>(std::move(lease));
+          boost::asio::post(*m_request_handler_thread_pool,
+                            [this, leased, &fragment_queue]() { build_and_complete(*leased, fragment_queue); });
+        } else {
+          build_and_complete(lease, fragment_queue);
         }
-      } else if (result.result_code == ResultCode::kNotYet) {
+      } else if (target.result_code == ResultCode::kNotYet) {
         TLOG_DEBUG(TLVL_WORK_STEPS) << "Re-queue request. "
-                                    << "With timestamp=" << result.data_request.trigger_timestamp;
-        std::lock_guard<std::mutex> wait_lock_guard(m_waiting_requests_lock);
-        m_waiting_requests.push_back(RequestElement(datarequest, &fragment_queue, 0));
+                                    << "With timestamp=" << target.request.trigger_timestamp;
+        wait_for_data(target.request, fragment_queue);
       }
-      auto t_req_end = std::chrono::high_resolution_clock::now();
-      auto us_req_took = std::chrono::duration_cast<std::chrono::microseconds>(t_req_end - t_req_begin);
-      TLOG_DEBUG(TLVL_WORK_STEPS) << "Responding to data request took: " << us_req_took.count() << "[us]";
-      // if (result.result_code == ResultCode::kFound) {
-      //   std::lock_guard<std::mutex> time_lock_guard(m_response_time_log_lock);
-      //   m_response_time_log.push_back( std::make_pair<int, int>(result.data_request.trigger_number,
-      //   us_req_took.count()) );
-      // }
-      m_response_time_acc.fetch_add(us_req_took.count());
-      m_handled_requests++;
-    });
+    }
+    lease_pin.reset();
+    exit_reader(reader_slot);
+
+    auto t_req_end = std::chrono::high_resolution_clock::now();
+    auto us_req_took = std::chrono::duration_cast<std::chrono::microseconds>(t_req_end - t_req_begin);
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Responding to " << targets.size() << " data request(s) took: "
+                                << us_req_took.count() << "[us]";
+    // if (result.result_code == ResultCode::kFound) {
+    //   std::lock_guard<std::mutex> time_lock_guard(m_response_time_log_lock);
+    //   m_response_time_log.push_back( std::make_pair<int, int>(result.data_request.trigger_number,
+    //   us_req_took.count()) );
+    // }
+    m_response_time_acc += us_req_took.count() * targets.size();
+    m_handled_requests += targets.size();
+  }
+
+  void notify_newest_timestamp(uint64_t timestamp) override // NOLINT(build/unsigned)
+  {
+    // Only the first crossing of the most urgent window end wakes the scheduler up
+    if (timestamp > m_waiting_top_window_end.load(std::memory_order_relaxed) &&
+        !m_waiting_notified.exchange(true)) {
+      wake_waiting_requests();
+    }
   }
 
   void get_info(opmonlib::InfoCollector& ci, int /*level*/) override
@@ -313,17 +478,23 @@ public:
     info.num_requests_delayed = m_num_requests_delayed.exchange(0);
     info.num_requests_uncategorized = m_num_requests_uncategorized.exchange(0);
     info.num_buffer_cleanups = m_num_buffer_cleanups.exchange(0);
-    info.num_requests_waiting = m_waiting_requests.size();
+    {
+      std::lock_guard<std::mutex> lock_guard(m_waiting_requests_lock);
+      info.num_requests_waiting = m_waiting_requests.size();
+    }
     info.num_requests_timed_out = m_num_requests_timed_out.exchange(0);
     info.is_recording = m_recording;
     info.num_payloads_written = m_payloads_written.exchange(0);
     info.recording_status = m_recording ? "⏺" : "⏸";
+    info.num_fragment_buffer_hits = m_fragment_buffer_pool.get_and_reset_hits();
+    info.num_fragment_buffer_misses = m_fragment_buffer_pool.get_and_reset_misses();
+    info.num_lease_fallbacks = m_num_lease_fallbacks.exchange(0);
 
     int new_pop_reqs = 0;
     int new_pop_count = 0;
     int new_occupancy = 0;
-    int handled_requests = m_handled_requests.exchange(0);
-    int response_time_total = m_response_time_acc.exchange(0);
+    uint64_t handled_requests = m_handled_requests.exchange(0);    // NOLINT(build/unsigned)
+    uint64_t response_time_total = m_response_time_acc.exchange(0); // NOLINT(build/unsigned)
     auto now = std::chrono::high_resolution_clock::now();
     new_pop_reqs = m_pop_reqs.exchange(0);
     new_pop_count = m_pops_count.exchange(0);
@@ -355,6 +526,26 @@ public:
                                     << " | Avarage response time: " << response_time_total / handled_requests << "[us]";
       info.avg_request_response_time = response_time_total / handled_requests;
     }
+    auto queue_wait = m_queue_wait_histogram.get_and_reset();
+    info.queue_wait_p50_ns = queue_wait.p50;
+    info.queue_wait_p99_ns = queue_wait.p99;
+    info.queue_wait_p999_ns = queue_wait.p999;
+    info.queue_wait_max_ns = queue_wait.max;
+    auto buffer_search = m_buffer_search_histogram.get_and_reset();
+    info.buffer_search_p50_ns = buffer_search.p50;
+    info.buffer_search_p99_ns = buffer_search.p99;
+    info.buffer_search_p999_ns = buffer_search.p999;
+    info.buffer_search_max_ns = buffer_search.max;
+    auto fragment_build = m_fragment_build_histogram.get_and_reset();
+    info.fragment_build_p50_ns = fragment_build.p50;
+    info.fragment_build_p99_ns = fragment_build.p99;
+    info.fragment_build_p999_ns = fragment_build.p999;
+    info.fragment_build_max_ns = fragment_build.max;
+    auto sink_push = m_sink_push_histogram.get_and_reset();
+    info.sink_push_p50_ns = sink_push.p50;
+    info.sink_push_p99_ns = sink_push.p99;
+    info.sink_push_p999_ns = sink_push.p999;
+    info.sink_push_max_ns = sink_push.max;
 
     m_t0 = now;
 
@@ -362,6 +553,19 @@ public:
   }
 
 protected:
+  // The recording thread is only started for the first recording
+  ReusableThread& recording_thread()
+  {
+    if (m_recording_thread == nullptr) {
+      m_recording_thread = std::make_unique<ReusableThread>(0);
+      m_recording_thread->set_name("recording", m_geoid.element_id);
+      if (!m_recording_thread->set_affinity(m_housekeeping_cpus)) {
+        ers::warning(ConfigurationError(ERS_HERE, m_geoid, "Could not set the CPU affinity of the recording thread"));
+      }
+    }
+    return *m_recording_thread;
+  }
+
   inline daqdataformats::FragmentHeader create_fragment_header(const dfmessages::DataRequest& dr)
   {
     daqdataformats::FragmentHeader fh;
@@ -404,31 +608,117 @@ protected:
     }
   }
 
+  void refill_fragment_buffers()
+  {
+    while (m_run_marker.load()) {
+      m_fragment_buffer_pool.refill();
+      m_fragment_buffer_pool.wait_for_refill(std::chrono::milliseconds(50));
+    }
+  }
+
   void periodic_cleanups()
   {
     while (m_run_marker.load()) {
-      cleanup_check();
+      periodic_cleanup();
       std::this_thread::sleep_for(std::chrono::milliseconds(50));
     }
   }
 
+  // Publish the oldest timestamp the calling reader may still access, cleanup does not pop past it.
+  // Returns the claimed slot, to be handed back with exit_reader(). Every request thread and the recording
+  // thread has a slot of its own, so a free one is found within a turn over the slots.
+  size_t enter_reader(uint64_t timestamp) // NOLINT(build/unsigned)
+  {
+    size_t slot = 0;
+    uint64_t expected = s_no_reader; // NOLINT(build/unsigned)
+    while (!m_reader_timestamps[slot].compare_exchange_weak(expected, timestamp)) {
+      expected = s_no_reader;
+      slot = (slot + 1) % m_num_reader_slots;
+      if (slot == 0) {
+        std::this_thread::yield();
+      }
+    }
+    // A pop that was already announced may have missed the publication, let it finish
+    while (m_cleanup_running.load()) {
+      std::this_thread::yield();
+    }
+    return slot;
+  }
+
+  // A lease slot for data that is already protected by the reader slot of the caller, so no cleanup has to
+  // be waited for. Empty when all lease slots are taken.
+  std::optional<size_t> try_enter_lease(uint64_t timestamp) // NOLINT(build/unsigned)
+  {
+    for (size_t slot = m_num_reader_slots; slot < m_num_reader_slots + m_num_lease_slots; ++slot) {
+      uint64_t expected = s_no_reader; // NOLINT(build/unsigned)
+      if (m_reader_timestamps[slot].compare_exchange_strong(expected, timestamp)) {
+        return slot;
+      }
+    }
+    return std::nullopt;
+  }
+
+  void exit_reader(size_t slot) { m_reader_timestamps[slot].store(s_no_reader, std::memory_order_release); }
+
+  // The cleanup barrier counts as a reader
+  uint64_t oldest_reader_timestamp() const // NOLINT(build/unsigned)
+  {
+    uint64_t oldest = m_cleanup_barrier ? m_cleanup_barrier() : s_no_reader; // NOLINT(build/unsigned)
+    for (size_t i = 0; i < m_num_reader_slots + m_num_lease_slots; ++i) {
+      oldest = std::min(oldest, m_reader_timestamps[i].load());
+    }
+    return oldest;
+  }
+
+  // Elements older than the one covering the timestamp, the covering one may still be read
+  size_t elements_older_than(uint64_t timestamp) // NOLINT(build/unsigned)
+  {
+    if (timestamp == s_no_reader) {
+      return m_latency_buffer->occupancy();
+    }
+    // Nothing is older while a reader sits at the front, no need to search
+    auto front = m_latency_buffer->front();
+    if (front == nullptr || front->get_first_timestamp() >= timestamp) {
+      return 0;
+    }
+    ReadoutType cut_element;
+    cut_element.set_first_timestamp(timestamp);
+    auto cut_iter = m_latency_buffer->lower_bound(cut_element, false);
+    return cut_iter == m_latency_buffer->end() ? 0 : m_latency_buffer->elements_before(cut_iter);
+  }
+
+  // Pop up to amount elements older than the cut, returns how many were popped. The search runs before the
+  // pop is announced. The readers are checked again after the announcement, a reader that published an older
+  // timestamp in between is seen there, and later ones wait in enter_reader() only for the pop itself.
+  size_t pop_older_than(uint64_t cut, size_t amount) // NOLINT(build/unsigned)
+  {
+    amount = std::min(amount, elements_older_than(cut));
+    if (amount == 0) {
+      return 0;
+    }
+    m_cleanup_running.store(true);
+    uint64_t oldest = std::min(m_next_timestamp_to_record.load(), oldest_reader_timestamp()); // NOLINT(build/unsigned)
+    if (oldest < cut) {
+      amount = std::min(amount, elements_older_than(oldest));
+    }
+    m_latency_buffer->pop(amount);
+    m_cleanup_running.store(false);
+    return amount;
+  }
+
   void cleanup()
   {
+    if (m_retention_ticks != 0) {
+      retention_cleanup();
+      return;
+    }
     // auto now_s = time::now_as<std::chrono::seconds>();
     auto size_guess = m_latency_buffer->occupancy();
     if (size_guess > m_pop_limit_size) {
       ++m_pop_reqs;
-      unsigned to_pop = m_pop_size_pct * m_latency_buffer->occupancy();
-
-      unsigned popped = 0;
-      for (size_t i = 0; i < to_pop; ++i) {
-        if (m_latency_buffer->front()->get_first_timestamp() < m_next_timestamp_to_record) {
-          m_latency_buffer->pop(1);
-          popped++;
-        } else {
-          break;
-        }
-      }
+      size_t to_pop = m_pop_size_pct * m_latency_buffer->occupancy();
+      uint64_t cut = std::min(m_next_timestamp_to_record.load(), oldest_reader_timestamp()); // NOLINT(build/unsigned)
+      size_t popped = pop_older_than(cut, to_pop);
       // m_pops_count += to_pop;
       m_occupancy = m_latency_buffer->occupancy();
       m_pops_count += popped;
@@ -437,87 +727,341 @@ protected:
     m_num_buffer_cleanups++;
   }
 
-  void check_waiting_requests()
+  // Keep the configured time span behind the newest element, everything older goes in one pop
+  void retention_cleanup()
   {
-    while (m_run_marker.load() || m_waiting_requests.size() > 0) {
-      {
-        std::lock_guard<std::mutex> lock_guard(m_waiting_requests_lock);
+    auto last_element = m_latency_buffer->back();
+    if (last_element != nullptr && last_element->get_first_timestamp() > m_retention_ticks) {
+      ++m_pop_reqs;
+      uint64_t cut = std::min({ last_element->get_first_timestamp() - m_retention_ticks, // NOLINT(build/unsigned)
+                                m_next_timestamp_to_record.load(),
+                                oldest_reader_timestamp() });
+      size_t popped = pop_older_than(cut, m_latency_buffer->occupancy());
+      m_occupancy = m_latency_buffer->occupancy();
+      m_pops_count += popped;
+      auto front_element = m_latency_buffer->front();
+      if (front_element != nullptr) {
+        m_error_registry->remove_errors_until(front_element->get_first_timestamp());
+      }
+    }
+    m_num_buffer_cleanups++;
+  }
 
-        auto last_frame = m_latency_buffer->back();                                       // NOLINT
-        uint64_t newest_ts = last_frame == nullptr ? std::numeric_limits<uint64_t>::min() // NOLINT(build/unsigned)
-                                                   : last_frame->get_first_timestamp();
+  void wake_waiting_requests()
+  {
+    // Taking the lock orders the wake-up with the scheduler going to sleep
+    { std::lock_guard<std::mutex> lock_guard(m_waiting_requests_lock); }
+    m_waiting_cv.notify_all();
+  }
 
-        size_t size = m_waiting_requests.size();
-        for (size_t i = 0; i < size;) {
-          if (m_waiting_requests[i].request.window_end < newest_ts) {
-            issue_request(m_waiting_requests[i].request, *(m_waiting_requests[i].fragment_sink));
-            std::swap(m_waiting_requests[i], m_waiting_requests.back());
-            m_waiting_requests.pop_back();
-            size--;
-          } else if (m_waiting_requests[i].retry_count >= m_retry_count) {
-            auto fragment = create_empty_fragment(m_waiting_requests[i].request);
+  void place_request_thread()
+  {
+    if (!set_thread_affinity(pthread_self(), m_request_cpus)) {
+      ers::warning(ConfigurationError(ERS_HERE, m_geoid, "Could not set the CPU affinity of a request thread"));
+    }
+  }
 
+  // The pool threads have no handles: every one of them takes one placement task, and none
+  // returns from it before all are placed
+  void place_request_pool()
+  {
+    if (m_request_cpus.empty()) {
+      return;
+    }
+    struct Placement
+    {
+      std::mutex lock;
+      std::condition_variable cv;
+      size_t placed = 0;
+    };
+    auto placement = std::make_shared<Placement>();
+    for (size_t i = 0; i < m_num_request_handling_threads; ++i) {
+      boost::asio::post(*m_request_handler_thread_pool, [this, placement]() {
+        place_request_thread();
+        std::unique_lock<std::mutex> lock(placement->lock);
+        ++placement->placed;
+        placement->cv.notify_all();
+        placement->cv.wait(lock, [&]() { return placement->placed == m_num_request_handling_threads; });
+      });
+    }
+    std::unique_lock<std::mutex> lock(placement->lock);
+    placement->cv.wait(lock, [&]() { return placement->placed == m_num_request_handling_threads; });
+  }
+
+  static uint64_t elapsed_ns(request_clock::time_point since) // NOLINT(build/unsigned)
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(request_clock::now() - since).count();
+  }
+
+  void complete_async(PendingResponse&& response, fragment_sink_t& fragment_queue)
+  {
+    response.queued = request_clock::now();
+    response.deadline = response.queued + std::chrono::milliseconds(m_fragment_queue_timeout);
+    std::lock_guard<std::mutex> lock_guard(m_pending_responses_lock);
+    m_pending_responses[&fragment_queue].emplace_back(std::move(response));
+    m_num_pending_responses++;
+    m_pending_responses_cv.notify_one();
+  }
+
+  void send_empty_fragment(const RequestElement& waiting)
+  {
+    complete_async(PendingResponse(create_empty_fragment(waiting.request)), *waiting.fragment_sink);
+  }
+
+  // Copies the pieces out of the latency buffer on the calling pool thread, only the push is left to the
+  // completion thread
+  void build_and_complete(FragmentLease& lease, fragment_sink_t& fragment_queue)
+  {
+    auto build_begin = request_clock::now();
+    auto fragment = lease.materialize(m_fragment_buffer_pool);
+    m_fragment_build_histogram.record(elapsed_ns(build_begin));
+    complete_async(PendingResponse(std::move(fragment)), fragment_queue);
+  }
+
+  // One push attempt, returns false when the response has to be tried again later
+  bool try_push(PendingResponse& response, fragment_sink_t& fragment_queue)
+  {
+    auto now = request_clock::now();
+    auto timeout = std::min(s_push_attempt_timeout,
+                            std::chrono::duration_cast<std::chrono::milliseconds>(
+                              std::max(response.deadline - now, request_clock::duration::zero())));
+    try { // Push to Fragment queue
+      TLOG_DEBUG(TLVL_QUEUE_PUSH) << "Sending fragment with trigger_number " << response.fragment->get_trigger_number()
+                                  << ", run number " << response.fragment->get_run_number() << ", and GeoID "
+                                  << response.fragment->get_element_id();
+      fragment_queue.push(std::move(response.fragment), timeout);
+      m_sink_push_histogram.record(elapsed_ns(response.queued));
+    } catch (const ers::Issue& excpt) {
+      if (response.fragment && request_clock::now() < response.deadline) {
+        return false;
+      }
+      ers::warning(CannotWriteToQueue(ERS_HERE, m_geoid, "fragment queue"));
+    }
+    return true;
+  }
+
+  // Pushes to the fragment sinks in turns, so that a slow sink neither blocks the request
+  // threads nor the responses to the other sinks
+  void complete_responses()
+  {
+    std::unique_lock<std::mutex> lock(m_pending_responses_lock);
+    while (m_completing_responses.load() || m_num_pending_responses > 0) {
+      if (m_num_pending_responses == 0) {
+        m_pending_responses_cv.wait_for(lock, std::chrono::milliseconds(10));
+        continue;
+      }
+      // Sinks are never removed from the map, so the iteration survives unlocking
+      for (auto& [fragment_queue, pending] : m_pending_responses) {
+        if (pending.empty()) {
+          continue;
+        }
+        auto response = std::move(pending.front());
+        pending.pop_front();
+        lock.unlock();
+        bool completed = try_push(response, *fragment_queue);
+        lock.lock();
+        if (completed) {
+          m_num_pending_responses--;
+        } else {
+          pending.emplace_front(std::move(response));
+        }
+      }
+    }
+  }
+
+  // Waiting requests are kept in two heaps, on window end and on deadline. Entries of requests
+  // already handled through the other heap are dropped lazily when they reach the top.
+  void check_waiting_requests()
+  {
+    std::unique_lock<std::mutex> lock(m_waiting_requests_lock);
+    while (m_run_marker.load() || !m_waiting_requests.empty()) {
+      auto last_frame = m_latency_buffer->back();                                       // NOLINT
+      uint64_t newest_ts = last_frame == nullptr ? std::numeric_limits<uint64_t>::min() // NOLINT(build/unsigned)
+                                                 : last_frame->get_first_timestamp();
+
+      while (!m_waiting_by_window_end.empty()) {
+        auto [window_end, id] = m_waiting_by_window_end.top();
+        auto waiting = m_waiting_requests.find(id);
+        if (waiting != m_waiting_requests.end()) {
+          if (window_end >= newest_ts) {
+            break;
+          }
+          issue_request(waiting->second.request, *(waiting->second.fragment_sink));
+          m_waiting_requests.erase(waiting);
+        }
+        m_waiting_by_window_end.pop();
+      }
+
+      auto now = request_clock::now();
+      while (!m_waiting_by_deadline.empty()) {
+        auto [deadline, id] = m_waiting_by_deadline.top();
+        auto waiting = m_waiting_requests.find(id);
+        if (waiting != m_waiting_requests.end()) {
+          if (deadline > now && m_run_marker.load()) {
+            break;
+          }
+          if (m_run_marker.load()) {
             ers::warning(dunedaq::readout::RequestTimedOut(ERS_HERE, m_geoid));
-            m_num_requests_bad++;
             m_num_requests_timed_out++;
-            try { // Push to Fragment queue
-              TLOG_DEBUG(TLVL_QUEUE_PUSH)
-                << "Sending fragment with trigger_number " << fragment->get_trigger_number() << ", run number "
-                << fragment->get_run_number() << ", and GeoID " << fragment->get_element_id();
-              m_waiting_requests[i].fragment_sink->push(std::move(fragment),
-                                                        std::chrono::milliseconds(m_fragment_queue_timeout));
-            } catch (const ers::Issue& excpt) {
-              std::ostringstream oss;
-              oss << "fragments output queue for link " << m_geoid.element_id;
-              ers::warning(CannotWriteToQueue(ERS_HERE, m_geoid, "fragment queue"));
-            }
-            std::swap(m_waiting_requests[i], m_waiting_requests.back());
-            m_waiting_requests.pop_back();
-            size--;
-          } else if (!m_run_marker.load()) {
-            auto fragment = create_empty_fragment(m_waiting_requests[i].request);
-
-            ers::warning(dunedaq::readout::EndOfRunEmptyFragment(ERS_HERE, m_geoid));
-            m_num_requests_bad++;
-            try { // Push to Fragment queue
-              TLOG_DEBUG(TLVL_QUEUE_PUSH)
-                << "Sending fragment with trigger_number " << fragment->get_trigger_number() << ", run number "
-                << fragment->get_run_number() << ", and GeoID " << fragment->get_element_id();
-              m_waiting_requests[i].fragment_sink->push(std::move(fragment),
-                                                        std::chrono::milliseconds(m_fragment_queue_timeout));
-            } catch (const ers::Issue& excpt) {
-              ers::warning(CannotWriteToQueue(ERS_HERE, m_geoid, "fragment queue"));
-            }
-            std::swap(m_waiting_requests[i], m_waiting_requests.back());
-            m_waiting_requests.pop_back();
-            size--;
           } else {
-            m_waiting_requests[i].retry_count++;
-            i++;
+            ers::warning(dunedaq::readout::EndOfRunEmptyFragment(ERS_HERE, m_geoid));
           }
+          m_num_requests_bad++;
+          send_empty_fragment(waiting->second);
+          m_waiting_requests.erase(waiting);
         }
+        m_waiting_by_deadline.pop();
+      }
+
+      m_waiting_top_window_end =
+        m_waiting_by_window_end.empty() ? s_no_waiting_request : m_waiting_by_window_end.top().first;
+      if (!m_run_marker.load() && m_waiting_requests.empty()) {
+        break;
+      }
+      auto woken = [&] { return m_waiting_notified.exchange(false) || !m_run_marker.load(); };
+      // Without deadlines only new data, a new request or the stop wakes the scheduler up
+      if (m_waiting_by_deadline.empty()) {
+        m_waiting_cv.wait(lock, woken);
+      } else {
+        m_waiting_cv.wait_until(lock, m_waiting_by_deadline.top().first, woken);
       }
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
   }
 
   RequestResult data_request(dfmessages::DataRequest dr) override
   {
-    // Prepare response
-    RequestResult rres(ResultCode::kUnknown, dr);
+    std::vector<RequestTarget> targets;
+    targets.emplace_back(dr, create_fragment_header(dr));
+    // The pieces are copied before the reader slot is given back, cleanup does not pop them meanwhile
+    auto reader_slot = enter_reader(dr.window_begin);
+    find_fragment_pieces(targets);
+
+    RequestResult rres(targets[0].result_code, dr);
+    if (rres.result_code != ResultCode::kNotYet) {
+      // Create fragment from pieces
+      rres.fragment = m_fragment_buffer_pool.make_fragment(targets[0].header, targets[0].pieces);
+    }
+    exit_reader(reader_slot);
 
-    // Prepare FragmentHeader and empty Fragment pieces list
-    auto frag_header = create_fragment_header(dr);
-    std::vector<std::pair<void*, size_t>> frag_pieces;
-    std::ostringstream oss;
+    return rres;
+  }
+
+  void wait_for_data(const dfmessages::DataRequest& datarequest, fragment_sink_t& fragment_queue)
+  {
+    bool earliest_deadline = false;
+    {
+      std::lock_guard<std::mutex> wait_lock_guard(m_waiting_requests_lock);
+      // After the stop the scheduler may already be gone, the request is answered right away
+      if (!m_run_marker.load()) {
+        ers::warning(dunedaq::readout::EndOfRunEmptyFragment(ERS_HERE, m_geoid));
+        m_num_requests_bad++;
+        send_empty_fragment(RequestElement(datarequest, &fragment_queue, request_clock::now()));
+        return;
+      }
+      auto id = m_next_waiting_id++;
+      auto deadline = request_clock::now() + m_request_timeout;
+      m_waiting_requests.emplace(id, RequestElement(datarequest, &fragment_queue, deadline));
+      m_waiting_by_window_end.emplace(datarequest.window_end, id);
+      m_waiting_by_deadline.emplace(deadline, id);
+      m_waiting_top_window_end = m_waiting_by_window_end.top().first;
+      // The scheduler sleeps until the previous earliest deadline, or without one
+      earliest_deadline = m_waiting_by_deadline.top().second == id;
+      if (earliest_deadline) {
+        m_waiting_notified.store(true);
+      }
+    }
+    if (earliest_deadline) {
+      m_waiting_cv.notify_all();
+    }
+  }
+
+  // For fixed tick types the frames of an element that fall in the window are found by arithmetic,
+  // and added as one contiguous piece. Returns false when the frames have to be checked one by one.
+  bool add_trimmed_piece(ReadoutType* element,
+                         uint64_t start_win_ts, // NOLINT(build/unsigned)
+                         uint64_t end_win_ts,   // NOLINT(build/unsigned)
+                         std::vector<std::pair<void*, size_t>>& frag_pieces)
+  {
+    if constexpr (ReadoutType::expected_tick_difference == 0) {
+      return false;
+    } else {
+      using FrameType = typename ReadoutType::FrameType;
+      const uint64_t tick = ReadoutType::expected_tick_difference; // NOLINT(build/unsigned)
+      const size_t frame_size = element->get_frame_size();
+      const size_t num_frames = element->get_num_frames();
+      FrameType* frames = element->begin();
+      if (num_frames == 0 || sizeof(FrameType) != frame_size || element->end() != frames + num_frames) {
+        return false;
+      }
+      // Frames are only where the arithmetic says when the element has no gaps
+      const uint64_t first_ts = frames[0].get_timestamp(); // NOLINT(build/unsigned)
+      if (frames[num_frames - 1].get_timestamp() != first_ts + (num_frames - 1) * tick) {
+        return false;
+      }
+      auto frame_index = [&](uint64_t ts) -> size_t { // NOLINT(build/unsigned)
+        return ts <= first_ts ? 0 : std::min<uint64_t>((ts - first_ts + tick - 1) / tick, num_frames);
+      };
+      const size_t first = frame_index(start_win_ts);
+      const size_t last = frame_index(end_win_ts);
+      if (last > first) {
+        frag_pieces.emplace_back(
+          std::make_pair<void*, size_t>(static_cast<void*>(frames + first), (last - first) * frame_size));
+      }
+      return true;
+    }
+  }
 
-    if (m_latency_buffer->occupancy() != 0) {
-      // Data availability is calculated here
-      auto front_element = m_latency_buffer->front();           // NOLINT
-      auto last_element = m_latency_buffer->back();             // NOLINT
-      uint64_t last_ts = front_element->get_first_timestamp();  // NOLINT(build/unsigned)
-      uint64_t newest_ts = last_element->get_first_timestamp(); // NOLINT(build/unsigned)
+  // Add the part of the element that falls in the window
+  void add_element_pieces(ReadoutType* element,
+                          uint64_t start_win_ts, // NOLINT(build/unsigned)
+                          uint64_t end_win_ts,   // NOLINT(build/unsigned)
+                          std::vector<std::pair<void*, size_t>>& frag_pieces)
+  {
+    if (element->get_first_timestamp() < start_win_ts ||
+        element->get_first_timestamp() + (element->get_num_frames() - 1) * ReadoutType::expected_tick_difference >=
+          end_win_ts) {
+      // We don't need the whole aggregated object (e.g.: superchunk)
+      if (!add_trimmed_piece(element, start_win_ts, end_win_ts, frag_pieces)) {
+        for (auto frame_iter = element->begin(); frame_iter != element->end(); frame_iter++) {
+          if ((*frame_iter).get_timestamp() >= start_win_ts && (*frame_iter).get_timestamp() < end_win_ts) {
+            frag_pieces.emplace_back(
+              std::make_pair<void*, size_t>(static_cast<void*>(&(*frame_iter)), element->get_frame_size()));
+          }
+        }
+      }
+    } else {
+      // We are somewhere in the middle -> the whole aggregated object (e.g.: superchunk) can be copied
+      frag_pieces.emplace_back(
+        std::make_pair<void*, size_t>(static_cast<void*>(element->begin()), element->get_payload_size()));
+    }
+  }
 
+  // Collect the pieces of the requested windows, they point into the latency buffer. Overlapping
+  // windows share a single search and traversal of the buffer.
+  void find_fragment_pieces(std::vector<RequestTarget>& targets)
+  {
+    if (m_latency_buffer->occupancy() == 0) {
+      for (auto& target : targets) {
+        ers::warning(RequestOnEmptyBuffer(ERS_HERE, m_geoid, "Data not found"));
+        target.header.error_bits |= (0x1 << static_cast<size_t>(daqdataformats::FragmentErrorBits::kDataNotFound));
+        target.result_code = ResultCode::kNotFound;
+        ++m_num_requests_bad;
+        ers::warning(dunedaq::readout::TrmWithEmptyFragment(ERS_HERE, m_geoid, ""));
+      }
+      return;
+    }
+
+    // Data availability is calculated here
+    auto front_element = m_latency_buffer->front();           // NOLINT
+    auto last_element = m_latency_buffer->back();             // NOLINT
+    uint64_t last_ts = front_element->get_first_timestamp();  // NOLINT(build/unsigned)
+    uint64_t newest_ts = last_element->get_first_timestamp(); // NOLINT(build/unsigned)
+
+    // Span of the windows that have their data in the buffer
+    uint64_t walk_begin_ts = std::numeric_limits<uint64_t>::max(); // NOLINT(build/unsigned)
+    uint64_t walk_end_ts = 0;                                      // NOLINT(build/unsigned)
+    for (auto& target : targets) {
+      auto& dr = target.request;
       uint64_t start_win_ts = dr.window_begin; // NOLINT(build/unsigned)
       uint64_t end_win_ts = dr.window_end;     // NOLINT(build/unsigned)
       TLOG_DEBUG(TLVL_WORK_STEPS) << "Data request for "
@@ -529,97 +1073,88 @@ protected:
 
       // List of safe-extraction conditions
       if (last_ts <= start_win_ts && end_win_ts <= newest_ts) { // data is there
-        ReadoutType request_element;
-        request_element.set_first_timestamp(start_win_ts);
-        auto start_iter = m_error_registry->has_error("MISSING_FRAMES") ? m_latency_buffer->lower_bound(request_element, true)
-                                                        : m_latency_buffer->lower_bound(request_element, false);
-        if (start_iter == m_latency_buffer->end()) {
-          // Due to some concurrent access, the start_iter could not be retrieved successfully, try again
-          ++m_num_requests_delayed;
-          rres.result_code = ResultCode::kNotYet; // give it another chance
-        } else {
-          rres.result_code = ResultCode::kFound;
-          ++m_num_requests_found;
-
-          auto elements_handled = 0;
-
-          ReadoutType* element = &(*start_iter);
-          while (start_iter.good() && element->get_first_timestamp() < end_win_ts) {
-            if (element->get_first_timestamp() < start_win_ts ||
-                element->get_first_timestamp() +
-                    (element->get_num_frames() - 1) * ReadoutType::expected_tick_difference >=
-                  end_win_ts) {
-              // We don't need the whole aggregated object (e.g.: superchunk)
-              for (auto frame_iter = element->begin(); frame_iter != element->end(); frame_iter++) {
-                if ((*frame_iter).get_timestamp() >= start_win_ts && (*frame_iter).get_timestamp() < end_win_ts) {
-                  frag_pieces.emplace_back(
-                    std::make_pair<void*, size_t>(static_cast<void*>(&(*frame_iter)), element->get_frame_size()));
-                }
-              }
-            } else {
-              // We are somewhere in the middle -> the whole aggregated object (e.g.: superchunk) can be copied
-              frag_pieces.emplace_back(
-                std::make_pair<void*, size_t>(static_cast<void*>((*start_iter).begin()), element->get_payload_size()));
-            }
-
-            elements_handled++;
-            ++start_iter;
-            element = &(*start_iter);
-          }
-        }
+        target.result_code = ResultCode::kFound;
+        walk_begin_ts = std::min(walk_begin_ts, start_win_ts);
+        walk_end_ts = std::max(walk_end_ts, end_win_ts);
       } else if (last_ts > start_win_ts) { // data is gone.
-        frag_header.error_bits |= (0x1 << static_cast<size_t>(daqdataformats::FragmentErrorBits::kDataNotFound));
-        rres.result_code = ResultCode::kNotFound;
+        target.header.error_bits |= (0x1 << static_cast<size_t>(daqdataformats::FragmentErrorBits::kDataNotFound));
+        target.result_code = ResultCode::kNotFound;
         ++m_num_requests_old_window;
         ++m_num_requests_bad;
       } else if (newest_ts < end_win_ts) {
         ++m_num_requests_delayed;
-        rres.result_code = ResultCode::kNotYet; // give it another chance
+        target.result_code = ResultCode::kNotYet; // give it another chance
       } else {
         TLOG() << "Don't know how to categorise this request";
-        frag_header.error_bits |= (0x1 << static_cast<size_t>(daqdataformats::FragmentErrorBits::kDataNotFound));
-        rres.result_code = ResultCode::kNotFound;
+        target.header.error_bits |= (0x1 << static_cast<size_t>(daqdataformats::FragmentErrorBits::kDataNotFound));
+        target.result_code = ResultCode::kNotFound;
         ++m_num_requests_uncategorized;
         ++m_num_requests_bad;
       }
+    }
 
+    if (walk_end_ts != 0) {
+      ReadoutType request_element;
+      request_element.set_first_timestamp(walk_begin_ts);
+      auto start_iter = m_error_registry->has_error("MISSING_FRAMES")
+                          ? m_latency_buffer->lower_bound(request_element, true)
+                          : m_latency_buffer->lower_bound(request_element, false);
+      if (start_iter == m_latency_buffer->end()) {
+        // Due to some concurrent access, the start_iter could not be retrieved successfully, try again
+        for (auto& target : targets) {
+          if (target.result_code == ResultCode::kFound) {
+            ++m_num_requests_delayed;
+            target.result_code = ResultCode::kNotYet; // give it another chance
+          }
+        }
+      } else {
+        for (auto& target : targets) {
+          if (target.result_code == ResultCode::kFound) {
+            ++m_num_requests_found;
+          }
+        }
+        ReadoutType* element = &(*start_iter);
+        while (start_iter.good() && element->get_first_timestamp() < walk_end_ts) {
+          uint64_t element_end_ts = // NOLINT(build/unsigned)
+            element->get_first_timestamp() + (element->get_num_frames() - 1) * ReadoutType::expected_tick_difference;
+          for (auto& target : targets) {
+            if (target.result_code == ResultCode::kFound && element->get_first_timestamp() < target.request.window_end &&
+                element_end_ts >= target.request.window_begin) {
+              add_element_pieces(element, target.request.window_begin, target.request.window_end, target.pieces);
+            }
+          }
+          ++start_iter;
+          element = &(*start_iter);
+        }
+      }
+    }
+
+    for (auto& target : targets) {
+      auto& dr = target.request;
       // Requeue if needed
-      if (rres.result_code == ResultCode::kNotYet) {
+      if (target.result_code == ResultCode::kNotYet) {
         if (m_run_marker.load()) {
-          return rres; // If kNotYet, return immediately, don't check for fragment pieces.
+          continue; // If kNotYet, don't report it yet.
         } else {
-          frag_header.error_bits |= (0x1 << static_cast<size_t>(daqdataformats::FragmentErrorBits::kDataNotFound));
-          rres.result_code = ResultCode::kNotFound;
+          target.header.error_bits |= (0x1 << static_cast<size_t>(daqdataformats::FragmentErrorBits::kDataNotFound));
+          target.result_code = ResultCode::kNotFound;
           ++m_num_requests_bad;
         }
       }
 
-      // Build fragment
+      std::ostringstream oss;
       oss << "TS match result on link " << m_geoid.element_id << ": " << ' ' << "Trigger number=" << dr.trigger_number
           << " "
           << "Oldest stored TS=" << last_ts << " "
-          << "Start of window TS=" << start_win_ts << " "
-          << "End of window TS=" << end_win_ts << " "
+          << "Start of window TS=" << dr.window_begin << " "
+          << "End of window TS=" << dr.window_end << " "
           << "Estimated newest stored TS=" << newest_ts;
       TLOG_DEBUG(TLVL_WORK_STEPS) << oss.str();
-    } else {
-      ers::warning(RequestOnEmptyBuffer(ERS_HERE, m_geoid, "Data not found"));
-      frag_header.error_bits |= (0x1 << static_cast<size_t>(daqdataformats::FragmentErrorBits::kDataNotFound));
-      rres.result_code = ResultCode::kNotFound;
-      ++m_num_requests_bad;
-    }
 
-    if (rres.result_code != ResultCode::kFound) {
-      ers::warning(dunedaq::readout::TrmWithEmptyFragment(ERS_HERE, m_geoid, oss.str()));
+      if (target.result_code != ResultCode::kFound) {
+        ers::warning(dunedaq::readout::TrmWithEmptyFragment(ERS_HERE, m_geoid, oss.str()));
+      }
     }
-
-    // Create fragment from pieces
-    rres.fragment = std::make_unique<daqdataformats::Fragment>(frag_pieces);
-
-    // Set header
-    rres.fragment->set_header_fields(frag_header);
-
-    return rres;
   }
 
   // Data access (LB)
@@ -627,25 +1162,75 @@ protected:
 
   // Data recording
   BufferedFileWriter<> m_buffered_writer;
-  ReusableThread m_recording_thread;
+  std::unique_ptr<ReusableThread> m_recording_thread;
 
-  ReusableThread m_cleanup_thread;
+  std::unique_ptr<ReusableThread> m_cleanup_thread;
+  std::vector<int> m_housekeeping_cpus;
+  bool m_external_cleanup = false;
+  std::function<uint64_t()> m_cleanup_barrier; // NOLINT(build/unsigned)
 
   // Bookkeeping of OOB requests
   std::map<dfmessages::DataRequest, int> m_request_counter;
 
   // Requests
   std::size_t m_max_requested_elements;
-  std::mutex m_cv_mutex;
-  std::condition_variable m_cv;
-  std::atomic<bool> m_cleanup_requested = false;
-  std::atomic<int> m_requests_running = 0;
-  std::vector<RequestElement> m_waiting_requests;
+  // Oldest timestamp held by each in-flight reader, s_no_reader for free slots
+  static constexpr uint64_t s_no_reader = std::numeric_limits<uint64_t>::max(); // NOLINT(build/unsigned)
+  std::unique_ptr<std::atomic<uint64_t>[]> m_reader_timestamps;                  // NOLINT(build/unsigned)
+  size_t m_num_reader_slots = 0;
+  size_t m_num_lease_slots = 0;
+  std::atomic<int> m_num_lease_fallbacks{ 0 };
+  std::atomic<bool> m_cleanup_running = false;
+  using waiting_window_end_t = std::pair<uint64_t, uint64_t>;                  // NOLINT(build/unsigned)
+  using waiting_deadline_t = std::pair<request_clock::time_point, uint64_t>; // NOLINT(build/unsigned)
+  static constexpr uint64_t s_no_waiting_request = std::numeric_limits<uint64_t>::max(); // NOLINT(build/unsigned)
+  std::unordered_map<uint64_t, RequestElement> m_waiting_requests; // NOLINT(build/unsigned)
+  std::priority_queue<waiting_window_end_t, std::vector<waiting_window_end_t>, std::greater<waiting_window_end_t>>
+    m_waiting_by_window_end;
+  std::priority_queue<waiting_deadline_t, std::vector<waiting_deadline_t>, std::greater<waiting_deadline_t>>
+    m_waiting_by_deadline;
+  uint64_t m_next_waiting_id = 0; // NOLINT(build/unsigned)
   std::mutex m_waiting_requests_lock;
+  std::condition_variable m_waiting_cv;
+  std::atomic<uint64_t> m_waiting_top_window_end = s_no_waiting_request; // NOLINT(build/unsigned)
+  std::atomic<bool> m_waiting_notified = false;
+
+  // Requests waiting for a thread of the pool, oldest window first
+  using scheduled_requests_t = std::tuple<uint64_t,                                                   // NOLINT
+                                          uint64_t,                                                   // NOLINT
+                                          request_clock::time_point,
+                                          std::vector<std::pair<dfmessages::DataRequest, fragment_sink_t*>>>;
+  struct ScheduledRequestsOrder
+  {
+    bool operator()(const scheduled_requests_t& a, const scheduled_requests_t& b) const
+    {
+      return std::tie(std::get<0>(a), std::get<1>(a)) > std::tie(std::get<0>(b), std::get<1>(b));
+    }
+  };
+  std::priority_queue<scheduled_requests_t, std::vector<scheduled_requests_t>, ScheduledRequestsOrder>
+    m_scheduled_requests;
+  uint64_t m_next_scheduled_id = 0; // NOLINT(build/unsigned)
+  std::mutex m_scheduled_requests_lock;
+
+  // Responses waiting to be pushed, per fragment sink
+  static constexpr size_t s_max_fragment_leases = 32;
+  static constexpr std::chrono::milliseconds s_push_attempt_timeout{ 1 };
+  bool m_lease_fragments = false;
+  std::map<fragment_sink_t*, std::deque<PendingResponse>> m_pending_responses;
+  size_t m_num_pending_responses = 0;
+  std::mutex m_pending_responses_lock;
+  std::condition_variable m_pending_responses_cv;
+  std::atomic<bool> m_completing_responses = false;
+  std::thread m_completion_thread;
+
+  // Buffers for the fragments built from the found pieces
+  FragmentBufferPool m_fragment_buffer_pool;
+  std::unique_ptr<ReusableThread> m_refill_thread;
 
   // Data extractor threads pool and corresponding requests
   std::unique_ptr<boost::asio::thread_pool> m_request_handler_thread_pool;
   size_t m_num_request_handling_threads = 0;
+  std::vector<int> m_request_cpus;
 
   // Error registry
   std::unique_ptr<FrameErrorRegistry>& m_error_registry;
@@ -663,7 +1248,9 @@ protected:
   float m_pop_limit_pct;     // buffer occupancy percentage to issue a pop request
   float m_pop_size_pct;      // buffer percentage to pop
   unsigned m_pop_limit_size; // pop_limit_pct * buffer_capacity
-  size_t m_retry_count;
+  std::chrono::milliseconds m_request_timeout;
+  uint64_t m_retention_ticks = 0; // NOLINT(build/unsigned)
+  static const constexpr int s_legacy_retry_period_ms = 10;
   size_t m_buffer_capacity;
   daqdataformats::GeoID m_geoid;
   static const constexpr uint32_t m_min_delay_us = 30000; // NOLINT(build/unsigned)
@@ -684,8 +1271,13 @@ protected:
   std::atomic<int> m_num_requests_delayed{ 0 };
   std::atomic<int> m_num_requests_uncategorized{ 0 };
   std::atomic<int> m_num_requests_timed_out{ 0 };
-  std::atomic<int> m_handled_requests{ 0 };
-  std::atomic<int> m_response_time_acc{ 0 };
+  std::atomic<uint64_t> m_handled_requests{ 0 };  // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_response_time_acc{ 0 }; // NOLINT(build/unsigned)
+  // Per stage service times of the requests, in ns
+  LatencyHistogram m_queue_wait_histogram;
+  LatencyHistogram m_buffer_search_histogram;
+  LatencyHistogram m_fragment_build_histogram;
+  LatencyHistogram m_sink_push_histogram;
   std::atomic<int> m_payloads_written{ 0 };
   // std::atomic<int> m_avg_req_count{ 0 }; // for opmon, later
   // std::atomic<int> m_avg_resp_time{ 0 };
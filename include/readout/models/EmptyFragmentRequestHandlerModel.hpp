@@ -60,6 +60,14 @@ public:
         ERS_HERE, DefaultRequestHandlerModel<ReadoutType, LatencyBufferType>::m_geoid, "fragment queue"));
     }
   }
+
+  void issue_requests(
+    std::vector<std::pair<dfmessages::DataRequest, typename inherited::fragment_sink_t*>> requests) override
+  {
+    for (auto& [datarequest, fragment_queue] : requests) {
+      issue_request(datarequest, *fragment_queue);
+    }
+  }
 };
 
 } // namespace readout
@@ -15,6 +15,11 @@
 
 #include "BinarySearchQueueModel.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <mutex>
+
 namespace dunedaq {
 namespace readout {
 
@@ -30,10 +35,48 @@ public:
     : BinarySearchQueueModel<T>(size)
   {}
 
+  void conf(const nlohmann::json& cfg) override
+  {
+    BinarySearchQueueModel<T>::conf(cfg);
+    std::lock_guard<std::mutex> lk(m_discontinuities_mutex);
+    m_discontinuities.clear();
+    m_num_discontinuities = 0;
+    m_has_previous = false;
+  }
+
+  bool write(T&& record) override
+  {
+    auto const current_write = IterableQueueModel<T>::writeIndex_.load(std::memory_order_relaxed);
+    forget_discontinuities(current_write, 1);
+    if (!BinarySearchQueueModel<T>::write(std::move(record))) {
+      return false;
+    }
+    track_discontinuities(current_write, 1);
+    return true;
+  }
+
+  std::size_t write_n(T* records, std::size_t n) override
+  {
+    auto const current_write = IterableQueueModel<T>::writeIndex_.load(std::memory_order_relaxed);
+    forget_discontinuities(current_write, std::min(n, IterableQueueModel<T>::free_slots()));
+    std::size_t written = BinarySearchQueueModel<T>::write_n(records, n);
+    track_discontinuities(current_write, written);
+    return written;
+  }
+
+  std::size_t commit(std::size_t n) override
+  {
+    auto const current_write = IterableQueueModel<T>::writeIndex_.load(std::memory_order_relaxed);
+    forget_discontinuities(current_write, n);
+    BinarySearchQueueModel<T>::commit(n);
+    track_discontinuities(current_write, n);
+    return n;
+  }
+
   typename IterableQueueModel<T>::Iterator lower_bound(T& element, bool with_errors = false)
   {
-    if (with_errors) {
-      return BinarySearchQueueModel<T>::lower_bound(element, with_errors);
+    if (with_errors || m_num_discontinuities.load(std::memory_order_relaxed) > 0) {
+      return lower_bound_with_discontinuities(element);
     }
     uint64_t timestamp = element.get_first_timestamp(); // NOLINT(build/unsigned)
     unsigned int start_index =
@@ -57,6 +100,126 @@ public:
     }
     return typename IterableQueueModel<T>::Iterator(*this, target_index);
   }
+
+protected:
+  // First slot of a contiguous run of elements, following a gap in the timestamps
+  struct Discontinuity
+  {
+    uint32_t slot;      // NOLINT(build/unsigned)
+    uint64_t timestamp; // NOLINT(build/unsigned)
+  };
+
+  // Drop the discontinuities living in the slots that are about to be overwritten, they are out of the buffer already
+  void forget_discontinuities(uint32_t first_slot, std::size_t n) // NOLINT(build/unsigned)
+  {
+    if (m_num_discontinuities.load(std::memory_order_relaxed) == 0) {
+      return;
+    }
+    const uint32_t size = IterableQueueModel<T>::size_; // NOLINT(build/unsigned)
+    std::lock_guard<std::mutex> lk(m_discontinuities_mutex);
+    while (!m_discontinuities.empty()) {
+      uint32_t slot = m_discontinuities.front().slot; // NOLINT(build/unsigned)
+      uint32_t offset = slot >= first_slot ? slot - first_slot : size + slot - first_slot; // NOLINT(build/unsigned)
+      if (offset >= n) {
+        break;
+      }
+      m_discontinuities.pop_front();
+    }
+    m_num_discontinuities.store(m_discontinuities.size(), std::memory_order_relaxed);
+  }
+
+  // Record the elements of the freshly written slots that do not follow their predecessor by the expected span
+  void track_discontinuities(uint32_t first_slot, std::size_t n) // NOLINT(build/unsigned)
+  {
+    uint32_t slot = first_slot; // NOLINT(build/unsigned)
+    for (std::size_t i = 0; i < n; ++i) {
+      T& record = IterableQueueModel<T>::records_[slot];
+      uint64_t timestamp = record.get_first_timestamp(); // NOLINT(build/unsigned)
+      if (m_has_previous && timestamp != m_previous_ts + m_previous_span) {
+        std::lock_guard<std::mutex> lk(m_discontinuities_mutex);
+        m_discontinuities.push_back({ slot, timestamp });
+        m_num_discontinuities.store(m_discontinuities.size(), std::memory_order_relaxed);
+      }
+      m_previous_ts = timestamp;
+      m_previous_span = T::expected_tick_difference * record.get_num_frames();
+      m_has_previous = true;
+      if (++slot == IterableQueueModel<T>::size_) {
+        slot = 0;
+      }
+    }
+  }
+
+  // Arithmetic lookup within the contiguous run that holds the timestamp, found in the discontinuity table
+  typename IterableQueueModel<T>::Iterator lower_bound_with_discontinuities(T& element)
+  {
+    uint64_t timestamp = element.get_first_timestamp(); // NOLINT(build/unsigned)
+    unsigned int start_index =
+      IterableQueueModel<T>::readIndex_.load(std::memory_order_relaxed); // NOLINT(build/unsigned)
+    unsigned int end_index =
+      IterableQueueModel<T>::writeIndex_.load(std::memory_order_acquire); // NOLINT(build/unsigned)
+    if (start_index == end_index) {
+      return IterableQueueModel<T>::end();
+    }
+    const uint32_t size = IterableQueueModel<T>::size_; // NOLINT(build/unsigned)
+    const uint32_t occupancy = end_index > start_index ? end_index - start_index : size + end_index - start_index; // NOLINT(build/unsigned)
+
+    uint64_t run_ts = IterableQueueModel<T>::records_[start_index].get_first_timestamp(); // NOLINT(build/unsigned)
+    if (timestamp < run_ts) {
+      return IterableQueueModel<T>::end();
+    }
+    uint32_t run_offset = 0;         // NOLINT(build/unsigned)
+    uint32_t run_end_offset = occupancy; // NOLINT(build/unsigned)
+    {
+      std::lock_guard<std::mutex> lk(m_discontinuities_mutex);
+      if (m_discontinuities.size() > s_max_discontinuities) {
+        return BinarySearchQueueModel<T>::lower_bound(element, true);
+      }
+      for (auto& disc : m_discontinuities) {
+        uint32_t offset = disc.slot >= start_index ? disc.slot - start_index : size + disc.slot - start_index; // NOLINT(build/unsigned)
+        if (offset == 0 || offset >= occupancy) {
+          continue; // Already popped, or starting the readable range anyway
+        }
+        if (disc.timestamp > timestamp) {
+          run_end_offset = offset;
+          break;
+        }
+        run_offset = offset;
+        run_ts = disc.timestamp;
+      }
+    }
+
+    uint32_t run_slot = start_index + run_offset; // NOLINT(build/unsigned)
+    if (run_slot >= size) {
+      run_slot -= size;
+    }
+    uint64_t span = T::expected_tick_difference * IterableQueueModel<T>::records_[run_slot].get_num_frames(); // NOLINT(build/unsigned)
+    // A timestamp falling into a gap resolves to the last element before the gap
+    uint64_t target_offset = std::min<uint64_t>(run_offset + (timestamp - run_ts) / span, run_end_offset - 1); // NOLINT(build/unsigned)
+    uint32_t target_index = start_index + target_offset; // NOLINT(build/unsigned)
+    if (target_index >= size) {
+      target_index -= size;
+    }
+
+    // The table trails the writer by one element, verify the result before handing it out
+    uint32_t next_index = target_index + 1 == size ? 0 : target_index + 1; // NOLINT(build/unsigned)
+    if (IterableQueueModel<T>::records_[target_index].get_first_timestamp() > timestamp ||
+        (target_offset + 1 < occupancy && IterableQueueModel<T>::records_[next_index].get_first_timestamp() <= timestamp)) {
+      return BinarySearchQueueModel<T>::lower_bound(element, true);
+    }
+    return typename IterableQueueModel<T>::Iterator(*this, target_index);
+  }
+
+  // Above this amount of gaps in the buffer the table is not worth scanning
+  static constexpr std::size_t s_max_discontinuities = 64;
+
+  std::deque<Discontinuity> m_discontinuities;
+  std::atomic<std::size_t> m_num_discontinuities{ 0 };
+  std::mutex m_discontinuities_mutex;
+
+  // Only touched by the writer
+  uint64_t m_previous_ts = 0;   // NOLINT(build/unsigned)
+  uint64_t m_previous_span = 0; // NOLINT(build/unsigned)
+  bool m_has_previous = false;
 };
 
 } // namespace readout
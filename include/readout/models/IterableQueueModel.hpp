@@ -28,16 +28,19 @@
 #include "readout/concepts/LatencyBufferConcept.hpp"
 #include "readout/readoutconfig/Nljs.hpp"
 #include "readout/readoutconfig/Structs.hpp"
+#include "readout/readoutinfo/InfoNljs.hpp"
 
 #include "logging/Logging.hpp"
 
 #include <folly/lang/Align.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdlib>
 #include <cxxabi.h>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <limits>
@@ -49,6 +52,8 @@
 #include <type_traits>
 #include <utility>
 
+#include <sys/mman.h>
+#include <unistd.h>
 #include <xmmintrin.h>
 
 #ifdef WITH_LIBNUMA_SUPPORT
@@ -77,6 +82,7 @@ struct IterableQueueModel : public LatencyBufferConcept<T>
     , numa_node_(0)
     , intrinsic_allocator_(false)
     , alignment_size_(0)
+    , huge_page_size_(0)
     , invalid_configuration_requested_(false)
     , size_(2)
     , records_(static_cast<T*>(std::malloc(sizeof(T) * 2)))
@@ -95,6 +101,7 @@ struct IterableQueueModel : public LatencyBufferConcept<T>
     , numa_node_(0)
     , intrinsic_allocator_(false)
     , alignment_size_(0)
+    , huge_page_size_(0)
     , invalid_configuration_requested_(false)
     , size_(size)
     , records_(static_cast<T*>(std::malloc(sizeof(T) * size)))
@@ -125,19 +132,21 @@ struct IterableQueueModel : public LatencyBufferConcept<T>
                      bool numa_aware = false,
                      uint8_t numa_node = 0, // NOLINT (build/unsigned)
                      bool intrinsic_allocator = false,
-                     std::size_t alignment_size = 0)
+                     std::size_t alignment_size = 0,
+                     std::size_t huge_page_size = 0)
     : LatencyBufferConcept<T>() // NOLINT(build/unsigned)
     , numa_aware_(numa_aware)
     , numa_node_(numa_node)
     , intrinsic_allocator_(intrinsic_allocator)
     , alignment_size_(alignment_size)
+    , huge_page_size_(huge_page_size)
     , invalid_configuration_requested_(false)
     , size_(size)
     , readIndex_(0)
     , writeIndex_(0)
   {
     assert(size >= 2);
-    allocate_memory(size, numa_aware, numa_node, intrinsic_allocator, alignment_size);
+    allocate_memory(size, numa_aware, numa_node, intrinsic_allocator, alignment_size, huge_page_size);
 
     if (!records_) {
       throw std::bad_alloc();
@@ -174,7 +183,10 @@ struct IterableQueueModel : public LatencyBufferConcept<T>
       }
     }
 
-    if (intrinsic_allocator_) {
+    if (mapped_size_ > 0) {
+      munmap(records_, mapped_size_);
+      mapped_size_ = 0;
+    } else if (intrinsic_allocator_) {
       _mm_free(records_);
     } else if (numa_aware_) {
 #ifdef WITH_LIBNUMA_SUPPORT
@@ -189,12 +201,18 @@ struct IterableQueueModel : public LatencyBufferConcept<T>
                        bool numa_aware = false,
                        uint8_t numa_node = 0, // NOLINT (build/unsigned)
                        bool intrinsic_allocator = false,
-                       std::size_t alignment_size = 0)
+                       std::size_t alignment_size = 0,
+                       std::size_t huge_page_size = 0)
   {
     assert(size >= 2);
     // TODO: check for valid alignment sizes! | July-21-2021 | Roland Sipos | rsipos@cern.ch
+    page_size_ = sysconf(_SC_PAGESIZE);
+    transparent_huge_pages_ = false;
 
-    if (intrinsic_allocator && alignment_size > 0) { // _mm allocator
+    if (huge_page_size > 0) { // huge page backed mapping, optionally bound to a NUMA node
+      allocate_huge_pages(size, numa_aware, numa_node, alignment_size, huge_page_size);
+
+    } else if (intrinsic_allocator && alignment_size > 0) { // _mm allocator
       records_ = static_cast<T*>(_mm_malloc(sizeof(T) * size, alignment_size));
 
     } else if (!intrinsic_allocator && alignment_size > 0) { // std aligned allocator
@@ -223,6 +241,65 @@ struct IterableQueueModel : public LatencyBufferConcept<T>
     numa_node_ = numa_node;
     intrinsic_allocator_ = intrinsic_allocator;
     alignment_size_ = alignment_size;
+    huge_page_size_ = huge_page_size;
+  }
+
+  void allocate_huge_pages(std::size_t size,
+                           bool numa_aware,
+                           uint8_t numa_node, // NOLINT (build/unsigned)
+                           std::size_t alignment_size,
+                           std::size_t huge_page_size)
+  {
+    if (huge_page_size & (huge_page_size - 1)) {
+      throw GenericConfigurationError(ERS_HERE, "Huge page size must be a power of two");
+    }
+    if (alignment_size > huge_page_size) {
+      throw GenericConfigurationError(ERS_HERE, "Alignment size can't be larger than the huge page size");
+    }
+
+    // The mapping has to be a multiple of the huge page size
+    std::size_t mapped_size = ((sizeof(T) * size + huge_page_size - 1) / huge_page_size) * huge_page_size;
+    int page_shift = __builtin_ctzll(huge_page_size);
+    void* mem = mmap(nullptr,
+                     mapped_size,
+                     PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (page_shift << MAP_HUGE_SHIFT),
+                     -1,
+                     0);
+    if (mem != MAP_FAILED) {
+      page_size_ = huge_page_size;
+    } else {
+      // No reserved huge pages of this size on the host (see /proc/meminfo): fall back to THP
+      TLOG() << "Could not map " << mapped_size << " bytes with " << huge_page_size
+             << " byte huge pages, falling back to transparent huge pages";
+      mem = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (mem == MAP_FAILED) {
+        records_ = nullptr;
+        return;
+      }
+      if (madvise(mem, mapped_size, MADV_HUGEPAGE) == 0) {
+        std::ifstream pmd_size("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size");
+        std::size_t thp_size = 0;
+        if (pmd_size >> thp_size && thp_size > 0) {
+          page_size_ = thp_size;
+          transparent_huge_pages_ = true;
+        }
+      }
+    }
+
+    // Nothing was touched yet, so the policy applies to every page faulted in later
+    if (numa_aware) {
+#ifdef WITH_LIBNUMA_SUPPORT
+      numa_tonode_memory(mem, mapped_size, numa_node);
+#else
+      munmap(mem, mapped_size);
+      throw GenericConfigurationError(ERS_HERE,
+                                      "NUMA allocation was requested but program was built without USE_LIBNUMA");
+#endif
+    }
+
+    mapped_size_ = mapped_size;
+    records_ = static_cast<T*>(mem);
   }
 
   // bool put(T& record) { return write(record); }
@@ -247,6 +324,56 @@ struct IterableQueueModel : public LatencyBufferConcept<T>
     return false;
   }
 
+  std::size_t write_n(T* records, std::size_t n) override
+  {
+    auto const currentWrite = writeIndex_.load(std::memory_order_relaxed);
+    std::size_t amount = std::min(n, free_slots());
+    auto slot = currentWrite;
+    for (std::size_t i = 0; i < amount; ++i) {
+      new (&records_[slot]) T(std::move(records[i]));
+      if (++slot == size_) {
+        slot = 0;
+      }
+    }
+    if (amount > 0) {
+      writeIndex_.store(slot, std::memory_order_release);
+    }
+    overflow_ctr += n - amount;
+    return amount;
+  }
+
+  std::size_t reserve(T*& span, std::size_t n) override
+  {
+    auto const currentWrite = writeIndex_.load(std::memory_order_relaxed);
+    // The span has to be contiguous, so it stops at the end of the ring
+    reserved_ = std::min({ n, free_slots(), static_cast<std::size_t>(size_ - currentWrite) });
+    for (std::size_t i = 0; i < reserved_; ++i) {
+      new (&records_[currentWrite + i]) T;
+    }
+    span = &records_[currentWrite];
+    return reserved_;
+  }
+
+  std::size_t commit(std::size_t n) override
+  {
+    assert(n <= reserved_);
+    auto const currentWrite = writeIndex_.load(std::memory_order_relaxed);
+    if (!std::is_trivially_destructible<T>::value) {
+      for (std::size_t i = n; i < reserved_; ++i) {
+        records_[currentWrite + i].~T();
+      }
+    }
+    reserved_ = 0;
+    if (n > 0) {
+      auto nextRecord = currentWrite + n;
+      if (nextRecord == size_) {
+        nextRecord = 0;
+      }
+      writeIndex_.store(nextRecord, std::memory_order_release);
+    }
+    return n;
+  }
+
   // move (or copy) the value at the front of the queue to given variable
   bool read(T& record) override
   {
@@ -281,12 +408,30 @@ struct IterableQueueModel : public LatencyBufferConcept<T>
     readIndex_.store(nextRecord, std::memory_order_release);
   }
 
-  // RS: Will this work?
-  void pop(std::size_t x)
+  // queue must hold at least x elements
+  void pop(std::size_t x) override
   {
-    for (std::size_t i = 0; i < x; i++) {
-      popFront();
+    if (x == 0) {
+      return;
+    }
+    auto const currentRead = readIndex_.load(std::memory_order_relaxed);
+    assert(x <= occupancy());
+
+    if (!std::is_trivially_destructible<T>::value) {
+      auto slot = currentRead;
+      for (std::size_t i = 0; i < x; ++i) {
+        records_[slot].~T();
+        if (++slot == size_) {
+          slot = 0;
+        }
+      }
     }
+    // A single store releases all the slots at once
+    std::size_t nextRecord = currentRead + x;
+    if (nextRecord >= size_) {
+      nextRecord -= size_;
+    }
+    readIndex_.store(nextRecord, std::memory_order_release);
   }
 
   bool isEmpty() const
@@ -377,7 +522,7 @@ struct IterableQueueModel : public LatencyBufferConcept<T>
               (currentWrite < currentRead && m_index < currentRead && m_index < currentWrite));
     }
 
-    uint32_t get_index() { return m_index; } // NOLINT(build/unsigned)
+    uint32_t get_index() const { return m_index; } // NOLINT(build/unsigned)
 
   private:
     IterableQueueModel<T>& m_queue;
@@ -433,6 +578,16 @@ struct IterableQueueModel : public LatencyBufferConcept<T>
     return Iterator(*this, std::numeric_limits<uint32_t>::max()); // NOLINT(build/unsigned)
   }
 
+  // Number of elements older than the one the iterator points to
+  std::size_t elements_before(const Iterator& iter)
+  {
+    if (iter == end()) {
+      return occupancy();
+    }
+    auto const currentRead = readIndex_.load(std::memory_order_relaxed);
+    return iter.get_index() >= currentRead ? iter.get_index() - currentRead : size_ + iter.get_index() - currentRead;
+  }
+
   void conf(const nlohmann::json& cfg) override
   {
     auto conf = cfg["latencybufferconf"].get<readoutconfig::LatencyBufferConf>();
@@ -443,7 +598,8 @@ struct IterableQueueModel : public LatencyBufferConcept<T>
                     conf.latency_buffer_numa_aware,
                     conf.latency_buffer_numa_node,
                     conf.latency_buffer_intrinsic_allocator,
-                    conf.latency_buffer_alignment_size);
+                    conf.latency_buffer_alignment_size,
+                    conf.latency_buffer_huge_page_size);
     readIndex_ = 0;
     writeIndex_ = 0;
 
@@ -466,7 +622,27 @@ struct IterableQueueModel : public LatencyBufferConcept<T>
     return alignment_size_;
   }
 
+  void get_info(opmonlib::InfoCollector& ci, int /*level*/) override
+  {
+    readoutinfo::LatencyBufferInfo info;
+    info.page_size = page_size_;
+    info.transparent_huge_pages = transparent_huge_pages_;
+    info.allocated_bytes = mapped_size_ > 0 ? mapped_size_ : sizeof(T) * size_;
+    ci.add(info);
+  }
+
 protected:
+  // Free slots as seen by the producer
+  std::size_t free_slots() const
+  {
+    int used = static_cast<int>(writeIndex_.load(std::memory_order_relaxed)) -
+               static_cast<int>(readIndex_.load(std::memory_order_acquire));
+    if (used < 0) {
+      used += static_cast<int>(size_);
+    }
+    return size_ - 1 - static_cast<std::size_t>(used);
+  }
+
   template<class... Args>
   bool write_(Args&&... recordArgs)
   {
@@ -499,14 +675,21 @@ protected:
   // hardware_destructive_interference_size is set to 128.
   // (Assuming cache line size of 64, so we use a cache line pair size of 128 )
   std::atomic<int> overflow_ctr{ 0 };
+  std::size_t reserved_ = 0;
 
   // NUMA awareness and aligned allocator usage
   bool numa_aware_;
   uint8_t numa_node_; // NOLINT (build/unsigned)
   bool intrinsic_allocator_;
   std::size_t alignment_size_;
+  std::size_t huge_page_size_;
   bool invalid_configuration_requested_;
 
+  // Page size actually backing records_, and mapping length if it was mmap-ed
+  std::size_t page_size_ = 0;
+  bool transparent_huge_pages_ = false;
+  std::size_t mapped_size_ = 0;
+
   std::thread ptrlogger;
 
   char pad0_[folly::hardware_destructive_interference_size]; // NOLINT(runtime/arrays)
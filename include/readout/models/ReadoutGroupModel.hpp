@@ -0,0 +1,239 @@
+/**
+ * @file ReadoutGroupModel.hpp Serves several links from one DataLinkHandler.
+ * Every link keeps its own ReadoutModel (latency buffer, processor, request handler),
+ * the consumer, request, timesync and cleanup work of all links is done by three shared threads.
+ *
+ * This is part of the DUNE DAQ , copyright 2021.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef READOUT_INCLUDE_READOUT_MODELS_READOUTGROUPMODEL_HPP_
+#define READOUT_INCLUDE_READOUT_MODELS_READOUTGROUPMODEL_HPP_
+
+#include "logging/Logging.hpp"
+
+#include "opmonlib/InfoCollector.hpp"
+
+#include "readout/ReadoutIssues.hpp"
+#include "readout/ReadoutLogging.hpp"
+#include "readout/concepts/ReadoutConcept.hpp"
+#include "readout/readoutconfig/Nljs.hpp"
+
+#include "readout/utils/ReusableThread.hpp"
+#include "readout/utils/ThreadAffinity.hpp"
+#include "readout/utils/WaitStrategy.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+using dunedaq::readout::logging::TLVL_WORK_STEPS;
+
+namespace dunedaq {
+namespace readout {
+
+class ReadoutGroupModel : public ReadoutConcept
+{
+public:
+  static constexpr std::chrono::microseconds s_consume_sleep{ 100 };
+  static constexpr std::chrono::milliseconds s_request_sleep{ 10 };
+  static constexpr std::chrono::milliseconds s_cleanup_period{ 50 };
+  static constexpr std::chrono::milliseconds s_timesync_period{ 100 };
+
+  ReadoutGroupModel(std::atomic<bool>& run_marker, std::vector<std::unique_ptr<ReadoutConcept>> links)
+    : m_run_marker(run_marker)
+    , m_links(std::move(links))
+    , m_consumer_thread(0)
+    , m_requester_thread(0)
+    , m_housekeeping_thread(0)
+  {}
+
+  // The links are initialized when they are created
+  void init(const nlohmann::json& /*args*/) override
+  {
+    for (auto& link : m_links) {
+      link->set_grouped(true);
+    }
+  }
+
+  void conf(const nlohmann::json& args) override
+  {
+    auto conf = args.get<readoutconfig::GroupConf>();
+    if (conf.links.size() != m_links.size()) {
+      throw GenericConfigurationError(ERS_HERE,
+                                      "Readout group with " + std::to_string(m_links.size()) + " links got " +
+                                        std::to_string(conf.links.size()) + " link configurations");
+    }
+    for (size_t i = 0; i < m_links.size(); ++i) {
+      m_links[i]->conf(args["links"][i]);
+    }
+
+    if (!m_consume_wait.set_mode(conf.consumer_wait_strategy) ||
+        !m_request_wait.set_mode(conf.request_wait_strategy)) {
+      ers::warning(GenericConfigurationError(ERS_HERE, "Unknown wait strategy for the readout group, sleeping"));
+    }
+
+    m_consumer_thread.set_name("grp-consumer", 0);
+    m_requester_thread.set_name("grp-requests", 0);
+    m_housekeeping_thread.set_name("grp-housekeep", 0);
+    auto& affinity = conf.threadaffinityconf;
+    if (!m_consumer_thread.set_affinity(resolve_cpus(affinity.consumer_cpus, affinity.cpus, affinity.numa_node)) ||
+        !m_requester_thread.set_affinity(resolve_cpus(affinity.request_cpus, affinity.cpus, affinity.numa_node)) ||
+        !m_housekeeping_thread.set_affinity(
+          resolve_cpus(affinity.housekeeping_cpus, affinity.cpus, affinity.numa_node))) {
+      ers::warning(GenericConfigurationError(ERS_HERE, "Could not set the CPU affinity of the readout group threads"));
+    }
+  }
+
+  void start(const nlohmann::json& args) override
+  {
+    for (auto& link : m_links) {
+      link->start(args);
+    }
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Starting the shared threads of " << m_links.size() << " links...";
+    m_consumer_thread.set_work(&ReadoutGroupModel::run_consume, this);
+    m_requester_thread.set_work(&ReadoutGroupModel::run_requests, this);
+    m_housekeeping_thread.set_work(&ReadoutGroupModel::run_timesync, this);
+  }
+
+  // The shared threads are done with the links before the links flush their buffers
+  void stop(const nlohmann::json& args) override
+  {
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Stopping the shared threads...";
+    m_consume_wait.notify_all();
+    m_request_wait.notify_all();
+    while (!m_consumer_thread.get_readiness() || !m_requester_thread.get_readiness() ||
+           !m_housekeeping_thread.get_readiness()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    for (auto& link : m_links) {
+      link->stop(args);
+    }
+  }
+
+  void record(const nlohmann::json& args) override
+  {
+    for (auto& link : m_links) {
+      link->record(args);
+    }
+  }
+
+  // Each link reports under its own child collector, link<N>
+  void get_info(opmonlib::InfoCollector& ci, int level) override
+  {
+    for (size_t i = 0; i < m_links.size(); ++i) {
+      opmonlib::InfoCollector link_ci;
+      m_links[i]->get_info(link_ci, level);
+      ci.add("link" + std::to_string(i), link_ci);
+    }
+  }
+
+  // A group is always driven by its own threads
+  void set_grouped(bool /*grouped*/) override {}
+
+  bool has_queued_input() override
+  {
+    return std::any_of(m_links.begin(), m_links.end(), [](auto& link) { return link->has_queued_input(); });
+  }
+
+  // One batch per link and call, so that a busy link does not starve the others
+  size_t consume_queued() override
+  {
+    size_t consumed = 0;
+    for (auto& link : m_links) {
+      consumed += link->consume_queued();
+    }
+    return consumed;
+  }
+
+  bool has_queued_requests() override
+  {
+    return std::any_of(m_links.begin(), m_links.end(), [](auto& link) { return link->has_queued_requests(); });
+  }
+
+  size_t issue_queued_requests() override
+  {
+    size_t issued = 0;
+    for (auto& link : m_links) {
+      issued += link->issue_queued_requests();
+    }
+    return issued;
+  }
+
+  void send_timesync() override
+  {
+    for (auto& link : m_links) {
+      link->send_timesync();
+    }
+  }
+
+  void periodic_cleanup() override
+  {
+    for (auto& link : m_links) {
+      link->periodic_cleanup();
+    }
+  }
+
+private:
+  void run_consume() override
+  {
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Shared consumer thread started...";
+    while (m_run_marker.load()) {
+      if (consume_queued() == 0) {
+        m_consume_wait.wait([&]() { return !m_run_marker.load() || has_queued_input(); });
+      }
+    }
+    // Take in what was queued before the stop
+    while (consume_queued() > 0) {
+    }
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Shared consumer thread joins... ";
+  }
+
+  // Requests are issued as soon as they are seen, request_coalescing_us of the links is not waited for
+  void run_requests() override
+  {
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Shared requester thread started...";
+    while (m_run_marker.load()) {
+      if (issue_queued_requests() == 0) {
+        m_request_wait.wait([&]() { return !m_run_marker.load() || has_queued_requests(); });
+      }
+    }
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Shared requester thread joins... ";
+  }
+
+  // Timesync and cleanup of all links
+  void run_timesync() override
+  {
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Shared housekeeping thread started...";
+    auto next_timesync = std::chrono::steady_clock::now();
+    while (m_run_marker.load()) {
+      periodic_cleanup();
+      auto now = std::chrono::steady_clock::now();
+      if (now >= next_timesync) {
+        send_timesync();
+        next_timesync = now + s_timesync_period;
+      }
+      std::this_thread::sleep_for(s_cleanup_period);
+    }
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Shared housekeeping thread joins...";
+  }
+
+  std::atomic<bool>& m_run_marker;
+  std::vector<std::unique_ptr<ReadoutConcept>> m_links;
+
+  ReusableThread m_consumer_thread;
+  WaitStrategy m_consume_wait{ s_consume_sleep };
+  ReusableThread m_requester_thread;
+  // Requests are pushed from outside the package, so parking only times out
+  WaitStrategy m_request_wait{ s_request_sleep };
+  ReusableThread m_housekeeping_thread;
+};
+
+} // namespace readout
+} // namespace dunedaq
+
+#endif // READOUT_INCLUDE_READOUT_MODELS_READOUTGROUPMODEL_HPP_
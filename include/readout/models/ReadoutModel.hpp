@@ -40,8 +40,11 @@
 
 #include "readout/ReadoutIssues.hpp"
 #include "readout/utils/ReusableThread.hpp"
+#include "readout/utils/WaitStrategy.hpp"
 
+#include <algorithm>
 #include <functional>
+#include <map>
 #include <memory>
 #include <string>
 #include <utility>
@@ -69,14 +72,11 @@ public:
     : m_run_marker(run_marker)
     , m_fake_trigger(false)
     , m_current_fake_trigger_id(0)
-    , m_consumer_thread(0)
     , m_source_queue_timeout_ms(0)
     , m_raw_data_source(nullptr)
     , m_latency_buffer_impl(nullptr)
     , m_raw_processor_impl(nullptr)
-    , m_requester_thread(0)
     , m_timesync_queue_timeout_ms(0)
-    , m_timesync_thread(0)
   {}
 
   void init(const nlohmann::json& args)
@@ -98,6 +98,9 @@ public:
     m_request_handler_impl.reset(new RequestHandlerType(m_latency_buffer_impl, m_error_registry));
     m_request_handler_impl->init(args);
     m_raw_processor_impl->init(args);
+    // Elements are not cleaned up while postprocess tasks still look at them
+    m_request_handler_impl->set_cleanup_barrier(
+      [this]() { return m_raw_processor_impl->get_oldest_unprocessed_timestamp(); });
   }
 
   void conf(const nlohmann::json& args)
@@ -109,11 +112,19 @@ public:
       m_fake_trigger = true;
     }
     m_source_queue_timeout_ms = std::chrono::milliseconds(conf.source_queue_timeout_ms);
+    m_request_coalescing_time = std::chrono::microseconds(conf.request_coalescing_us);
+    // Batches are postprocessed in place, LBs that copy on commit consume one element at a time
+    m_consume_batch_size =
+      m_latency_buffer_impl->commits_in_place() ? static_cast<size_t>(std::max(1, conf.consume_batch_size)) : 1;
     TLOG_DEBUG(TLVL_WORK_STEPS) << "ReadoutModel creation";
 
     m_geoid.element_id = conf.element_id;
     m_geoid.region_id = conf.region_id;
     m_geoid.system_type = ReadoutType::system_type;
+    if (!m_request_wait.set_mode(conf.request_wait_strategy)) {
+      ers::warning(
+        ConfigurationError(ERS_HERE, m_geoid, "Unknown request_wait_strategy " + conf.request_wait_strategy + ", sleeping"));
+    }
 
     // Configure implementations:
     m_raw_processor_impl->conf(args);
@@ -121,15 +132,30 @@ public:
     try {
       m_latency_buffer_impl->conf(args);
     } catch (const std::bad_alloc& be) {
-      ers::error(ConfigurationError(ERS_HERE, m_geoid, "Latency Buffer can't be allocated with size!"));
+      // Nothing works without the buffer, the configuration fails
+      throw ConfigurationError(ERS_HERE, m_geoid, "Latency Buffer can't be allocated with size!");
     }
 
     m_request_handler_impl->conf(args);
 
-    // Configure threads:
-    m_consumer_thread.set_name("consumer", conf.element_id);
-    m_timesync_thread.set_name("timesync", conf.element_id);
-    m_requester_thread.set_name("requests", conf.element_id);
+    // Configure threads, a grouped link is driven by the threads of its group and has none of its own:
+    if (m_grouped) {
+      return;
+    }
+    if (m_consumer_thread == nullptr) {
+      m_consumer_thread = std::make_unique<ReusableThread>(0);
+      m_timesync_thread = std::make_unique<ReusableThread>(0);
+      m_requester_thread = std::make_unique<ReusableThread>(0);
+    }
+    m_consumer_thread->set_name("consumer", conf.element_id);
+    m_timesync_thread->set_name("timesync", conf.element_id);
+    m_requester_thread->set_name("requests", conf.element_id);
+    auto affinity = args["threadaffinityconf"].get<readoutconfig::ThreadAffinityConf>();
+    if (!m_consumer_thread->set_affinity(resolve_cpus(affinity.consumer_cpus, affinity.cpus, affinity.numa_node)) ||
+        !m_timesync_thread->set_affinity(resolve_cpus(affinity.housekeeping_cpus, affinity.cpus, affinity.numa_node)) ||
+        !m_requester_thread->set_affinity(resolve_cpus(affinity.request_cpus, affinity.cpus, affinity.numa_node))) {
+      ers::warning(ConfigurationError(ERS_HERE, m_geoid, "Could not set the CPU affinity of the readout threads"));
+    }
   }
 
   void start(const nlohmann::json& args)
@@ -143,16 +169,21 @@ public:
     m_stats_packet_count = 0;
     m_rawq_timeout_count = 0;
 
+    m_invalid_timesync_reported = false;
+
     m_t0 = std::chrono::high_resolution_clock::now();
 
     TLOG_DEBUG(TLVL_WORK_STEPS) << "Starting threads...";
     m_raw_processor_impl->start(args);
     m_request_handler_impl->start(args);
-    m_consumer_thread.set_work(
+    if (m_grouped) {
+      return;
+    }
+    m_consumer_thread->set_work(
       &ReadoutModel<ReadoutType, RequestHandlerType, LatencyBufferType, RawDataProcessorType>::run_consume, this);
-    m_requester_thread.set_work(
+    m_requester_thread->set_work(
       &ReadoutModel<ReadoutType, RequestHandlerType, LatencyBufferType, RawDataProcessorType>::run_requests, this);
-    m_timesync_thread.set_work(
+    m_timesync_thread->set_work(
       &ReadoutModel<ReadoutType, RequestHandlerType, LatencyBufferType, RawDataProcessorType>::run_timesync, this);
   }
 
@@ -160,18 +191,23 @@ public:
   {
     TLOG_DEBUG(TLVL_WORK_STEPS) << "Stoppping threads...";
     m_request_handler_impl->stop(args);
-    while (!m_timesync_thread.get_readiness()) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
-    }
-    while (!m_consumer_thread.get_readiness()) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
-    }
-    while (!m_requester_thread.get_readiness()) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    if (m_grouped) {
+      clear_request_queues();
+    } else {
+      while (!m_timesync_thread->get_readiness()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+      while (!m_consumer_thread->get_readiness()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+      while (!m_requester_thread->get_readiness()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
     }
+    // Postprocessing is done with the elements before they are flushed
+    m_raw_processor_impl->stop(args);
     TLOG_DEBUG(TLVL_WORK_STEPS) << "Flushing latency buffer with occupancy: " << m_latency_buffer_impl->occupancy();
     m_latency_buffer_impl->flush();
-    m_raw_processor_impl->stop(args);
     m_raw_processor_impl->reset_last_daq_time();
   }
 
@@ -184,6 +220,7 @@ public:
     ri.num_payloads = m_num_payloads.exchange(0);
     ri.sum_requests = m_sum_requests.load();
     ri.num_requests = m_num_requests.exchange(0);
+    ri.num_coalesced_request_groups = m_num_coalesced_groups.exchange(0);
     ri.num_payloads_overwritten = m_num_payloads_overwritten.exchange(0);
     ri.num_buffer_elements = m_latency_buffer_impl->occupancy();
 
@@ -203,10 +240,83 @@ public:
 
     ci.add(ri);
 
+    m_latency_buffer_impl->get_info(ci, level);
     m_request_handler_impl->get_info(ci, level);
     m_raw_processor_impl->get_info(ci, level);
   }
 
+  void set_grouped(bool grouped) override
+  {
+    m_grouped = grouped;
+    m_request_handler_impl->set_external_cleanup(grouped);
+  }
+
+  bool has_queued_input() override { return m_raw_data_source->can_pop(); }
+
+  size_t consume_queued() override
+  {
+    return m_raw_data_source->can_pop() ? consume_batch(std::chrono::milliseconds(0)) : 0;
+  }
+
+  bool has_queued_requests() override
+  {
+    return std::any_of(m_data_request_queues.begin(), m_data_request_queues.end(), [](auto& queue) {
+      return queue->can_pop();
+    });
+  }
+
+  size_t issue_queued_requests() override
+  {
+    collect_requests(m_queued_requests);
+    auto issued = m_queued_requests.size();
+    issue_coalesced_requests(m_queued_requests);
+    m_queued_requests.clear();
+    return issued;
+  }
+
+  void send_timesync() override
+  {
+    try {
+      auto timesyncmsg = dfmessages::TimeSync(m_raw_processor_impl->get_last_daq_time());
+      // TLOG() << "New timesync: daq=" << timesyncmsg.daq_time << " wall=" << timesyncmsg.system_time;
+      if (timesyncmsg.daq_time != 0) {
+        try {
+          m_timesync_sink->push(std::move(timesyncmsg));
+        } catch (const ers::Issue& excpt) {
+          ers::warning(CannotWriteToQueue(ERS_HERE, m_geoid, "timesync message queue", excpt));
+        }
+
+        if (m_fake_trigger) {
+          dfmessages::DataRequest dr;
+          ++m_current_fake_trigger_id;
+          dr.trigger_number = m_current_fake_trigger_id;
+          dr.trigger_timestamp = timesyncmsg.daq_time > 500 * us ? timesyncmsg.daq_time - 500 * us : 0;
+          auto width = 300000;
+          uint offset = 100;
+          dr.window_begin = dr.trigger_timestamp > offset ? dr.trigger_timestamp - offset : 0;
+          dr.window_end = dr.window_begin + width;
+          TLOG_DEBUG(TLVL_WORK_STEPS) << "Issuing fake trigger based on timesync. "
+                                      << " ts=" << dr.trigger_timestamp << " window_begin=" << dr.window_begin
+                                      << " window_end=" << dr.window_end;
+          for (size_t i = 0; i < m_data_response_queues.size(); ++i) {
+            m_request_handler_impl->issue_request(dr, *m_data_response_queues[i]);
+          }
+          ++m_num_requests;
+          ++m_sum_requests;
+        }
+      } else {
+        if (!m_invalid_timesync_reported) {
+          TLOG() << "Timesync with DAQ time 0 won't be sent out as it's an invalid sync.";
+          m_invalid_timesync_reported = true;
+        }
+      }
+    } catch (const dunedaq::appfwk::QueueTimeoutExpired& excpt) {
+      // ++m_timesyncqueue_timeout;
+    }
+  }
+
+  void periodic_cleanup() override { m_request_handler_impl->periodic_cleanup(); }
+
 private:
   void setup_request_response_queues(const nlohmann::json& args)
   {
@@ -234,26 +344,64 @@ private:
 
     TLOG_DEBUG(TLVL_WORK_STEPS) << "Consumer thread started...";
     while (m_run_marker.load() || m_raw_data_source->can_pop()) {
-      ReadoutType payload;
-      // Try to acquire data
-      try {
-        // m_raw_data_source->pop(payload_ptr, m_source_queue_timeout_ms);
-        m_raw_data_source->pop(payload, m_source_queue_timeout_ms);
-        m_raw_processor_impl->preprocess_item(&payload);
-        if (!m_latency_buffer_impl->write(std::move(payload))) {
-          TLOG_DEBUG(TLVL_TAKE_NOTE) << "***ERROR: Latency buffer is full and data was overwritten!";
-          m_num_payloads_overwritten++;
-        }
-        m_raw_processor_impl->postprocess_item(m_latency_buffer_impl->back());
-        ++m_num_payloads;
-        ++m_sum_payloads;
-        ++m_stats_packet_count;
-      } catch (const dunedaq::appfwk::QueueTimeoutExpired& excpt) {
+      consume_batch(m_source_queue_timeout_ms);
+    }
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Consumer thread joins... ";
+  }
+
+  // Pop a batch into the LB, the first element is waited for at most timeout. Returns the number popped.
+  size_t consume_batch(std::chrono::milliseconds timeout)
+  {
+    // Pop straight into the next free slots of the LB, when there are some
+    ReadoutType* payload = nullptr;
+    size_t reserved = m_latency_buffer_impl->reserve(payload, m_consume_batch_size);
+    if (reserved == 0) {
+      if (!m_overflow_payload) {
+        m_overflow_payload = std::make_unique<ReadoutType>();
+      }
+      payload = m_overflow_payload.get();
+    }
+    // Only the first element is waited for, the batch takes whatever else is already queued
+    size_t popped = 0;
+    try {
+      do {
+        m_raw_data_source->pop(payload[popped], popped == 0 ? timeout : std::chrono::milliseconds(0));
+        m_raw_processor_impl->preprocess_item(payload + popped);
+        ++popped;
+      } while (popped < reserved && m_raw_data_source->can_pop());
+    } catch (const dunedaq::appfwk::QueueTimeoutExpired& excpt) {
+      if (popped == 0) {
         ++m_rawq_timeout_count;
         // ers::error(QueueTimeoutError(ERS_HERE, " raw source "));
       }
     }
-    TLOG_DEBUG(TLVL_WORK_STEPS) << "Consumer thread joins... ";
+    if (reserved == 0) {
+      if (popped > 0) {
+        TLOG_DEBUG(TLVL_TAKE_NOTE) << "***ERROR: Latency buffer is full and data was overwritten!";
+        m_num_payloads_overwritten++;
+        m_raw_processor_impl->postprocess_item(m_latency_buffer_impl->back());
+      }
+    } else {
+      auto timestamp = popped > 0 ? payload[popped - 1].get_first_timestamp() : 0;
+      size_t committed = m_latency_buffer_impl->commit(popped);
+      if (popped == 0) {
+        return 0;
+      }
+      if (committed < popped) {
+        TLOG_DEBUG(TLVL_TAKE_NOTE) << "***ERROR: Latency buffer is full and data was overwritten!";
+        m_num_payloads_overwritten += popped - committed;
+      }
+      m_request_handler_impl->notify_newest_timestamp(timestamp);
+      if (m_latency_buffer_impl->commits_in_place()) {
+        m_raw_processor_impl->postprocess_items(payload, popped);
+      } else {
+        m_raw_processor_impl->postprocess_item(m_latency_buffer_impl->back());
+      }
+    }
+    m_num_payloads += popped;
+    m_sum_payloads += popped;
+    m_stats_packet_count += popped;
+    return popped;
   }
 
   void run_timesync()
@@ -261,88 +409,123 @@ private:
     TLOG_DEBUG(TLVL_WORK_STEPS) << "TimeSync thread started...";
     m_num_requests = 0;
     m_sum_requests = 0;
-    auto once_per_run = true;
     while (m_run_marker.load()) {
-      try {
-        auto timesyncmsg = dfmessages::TimeSync(m_raw_processor_impl->get_last_daq_time());
-        // TLOG() << "New timesync: daq=" << timesyncmsg.daq_time << " wall=" << timesyncmsg.system_time;
-        if (timesyncmsg.daq_time != 0) {
-          try {
-            m_timesync_sink->push(std::move(timesyncmsg));
-          } catch (const ers::Issue& excpt) {
-            ers::warning(CannotWriteToQueue(ERS_HERE, m_geoid, "timesync message queue", excpt));
-          }
-
-          if (m_fake_trigger) {
-            dfmessages::DataRequest dr;
-            ++m_current_fake_trigger_id;
-            dr.trigger_number = m_current_fake_trigger_id;
-            dr.trigger_timestamp = timesyncmsg.daq_time > 500 * us ? timesyncmsg.daq_time - 500 * us : 0;
-            auto width = 300000;
-            uint offset = 100;
-            dr.window_begin = dr.trigger_timestamp > offset ? dr.trigger_timestamp - offset : 0;
-            dr.window_end = dr.window_begin + width;
-            TLOG_DEBUG(TLVL_WORK_STEPS) << "Issuing fake trigger based on timesync. "
-                                        << " ts=" << dr.trigger_timestamp << " window_begin=" << dr.window_begin
-                                        << " window_end=" << dr.window_end;
-            for (size_t i = 0; i < m_data_response_queues.size(); ++i) {
-              m_request_handler_impl->issue_request(dr, *m_data_response_queues[i]);
-            }
-            ++m_num_requests;
-            ++m_sum_requests;
-          }
-        } else {
-          if (once_per_run) {
-            TLOG() << "Timesync with DAQ time 0 won't be sent out as it's an invalid sync.";
-            once_per_run = false;
-          }
-        }
-      } catch (const dunedaq::appfwk::QueueTimeoutExpired& excpt) {
-        // ++m_timesyncqueue_timeout;
-      }
+      send_timesync();
       std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
-    once_per_run = true;
     TLOG_DEBUG(TLVL_WORK_STEPS) << "TimeSync thread joins...";
   }
 
-  void run_requests()
+  using request_list_t =
+    std::vector<std::pair<dfmessages::DataRequest, appfwk::DAQSink<std::unique_ptr<daqdataformats::Fragment>>*>>;
+
+  // Pop everything that is waiting on the request queues
+  void collect_requests(request_list_t& requests)
   {
-    TLOG_DEBUG(TLVL_WORK_STEPS) << "Requester thread started...";
-    m_num_requests = 0;
-    m_sum_requests = 0;
     dfmessages::DataRequest data_request;
-
-    while (m_run_marker.load()) {
-      bool popped_element = false;
-      for (size_t i = 0; i < m_data_request_queues.size(); ++i) {
-        auto& request_source = *m_data_request_queues[i];
-        auto& response_sink = *m_data_response_queues[i];
-        try {
+    for (size_t i = 0; i < m_data_request_queues.size(); ++i) {
+      auto& request_source = *m_data_request_queues[i];
+      try {
+        while (true) {
           request_source.pop(data_request, std::chrono::milliseconds(0));
-          popped_element = true;
-          m_request_handler_impl->issue_request(data_request, response_sink);
+          requests.emplace_back(data_request, m_data_response_queues[i].get());
           ++m_num_requests;
           ++m_sum_requests;
           TLOG_DEBUG(TLVL_QUEUE_POP) << "Received DataRequest for trigger_number " << data_request.trigger_number
                                      << ", run number " << data_request.run_number << " (APA number "
                                      << m_geoid.region_id << ", link number " << m_geoid.element_id << ")";
-        } catch (const dunedaq::appfwk::QueueTimeoutExpired& excpt) {
-          // not an error, safe to continue
         }
+      } catch (const dunedaq::appfwk::QueueTimeoutExpired& excpt) {
+        // not an error, safe to continue
       }
-      if (!popped_element) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  }
+
+  // Requests of the same trigger or with overlapping windows are issued as one group. The requests of a
+  // trigger are kept together first, whatever their windows, then triggers with overlapping spans are merged.
+  void issue_coalesced_requests(request_list_t& requests)
+  {
+    using trigger_key_t = std::pair<decltype(dfmessages::DataRequest::run_number),
+                                    decltype(dfmessages::DataRequest::trigger_number)>;
+    std::map<trigger_key_t, request_list_t> by_trigger;
+    for (auto& request : requests) {
+      by_trigger[trigger_key_t(request.first.run_number, request.first.trigger_number)].push_back(request);
+    }
+
+    // Window span of every trigger
+    struct TriggerSpan
+    {
+      uint64_t begin; // NOLINT(build/unsigned)
+      uint64_t end;   // NOLINT(build/unsigned)
+      request_list_t* requests;
+    };
+    std::vector<TriggerSpan> spans;
+    spans.reserve(by_trigger.size());
+    for (auto& [key, trigger_requests] : by_trigger) {
+      TriggerSpan span{ trigger_requests.front().first.window_begin, trigger_requests.front().first.window_end,
+                        &trigger_requests };
+      for (auto& request : trigger_requests) {
+        span.begin = std::min<uint64_t>(span.begin, request.first.window_begin); // NOLINT(build/unsigned)
+        span.end = std::max<uint64_t>(span.end, request.first.window_end);       // NOLINT(build/unsigned)
+      }
+      spans.push_back(span);
+    }
+    std::sort(spans.begin(), spans.end(), [](const auto& a, const auto& b) { return a.begin < b.begin; });
+
+    size_t group_begin = 0;
+    while (group_begin < spans.size()) {
+      request_list_t group(*spans[group_begin].requests);
+      auto group_window_end = spans[group_begin].end;
+      size_t group_end = group_begin + 1;
+      while (group_end < spans.size() && spans[group_end].begin < group_window_end) {
+        group.insert(group.end(), spans[group_end].requests->begin(), spans[group_end].requests->end());
+        group_window_end = std::max(group_window_end, spans[group_end].end);
+        ++group_end;
+      }
+      if (group.size() == 1) {
+        m_request_handler_impl->issue_request(group.front().first, *group.front().second);
+      } else {
+        ++m_num_coalesced_groups;
+        m_request_handler_impl->issue_requests(std::move(group));
+      }
+      group_begin = group_end;
+    }
+  }
+
+  void run_requests()
+  {
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Requester thread started...";
+    m_num_requests = 0;
+    m_sum_requests = 0;
+    request_list_t requests;
+
+    while (m_run_marker.load()) {
+      collect_requests(requests);
+      if (requests.empty()) {
+        m_request_wait.wait([&]() { return !m_run_marker.load() || has_queued_requests(); });
+        continue;
       }
+      // Give the other consumers of the same trigger a chance to ask as well
+      if (m_request_coalescing_time.count() > 0) {
+        std::this_thread::sleep_for(m_request_coalescing_time);
+        collect_requests(requests);
+      }
+      issue_coalesced_requests(requests);
+      requests.clear();
     }
 
-    // Clear queues
+    clear_request_queues();
+    TLOG_DEBUG(TLVL_WORK_STEPS) << "Requester thread joins... ";
+  }
+
+  void clear_request_queues()
+  {
+    dfmessages::DataRequest data_request;
     for (auto& queue : m_data_request_queues) {
       while (queue->can_pop()) {
         queue->pop(data_request, m_source_queue_timeout_ms);
       }
     }
-    TLOG_DEBUG(TLVL_WORK_STEPS) << "Requester thread joins... ";
   }
 
   // Constuctor params
@@ -353,21 +536,24 @@ private:
   bool m_fake_trigger;
   int m_current_fake_trigger_id;
   daqdataformats::GeoID m_geoid;
+  bool m_grouped = false;
 
   // STATS
   std::atomic<int> m_num_payloads{ 0 };
   std::atomic<int> m_sum_payloads{ 0 };
   std::atomic<int> m_num_requests{ 0 };
   std::atomic<int> m_sum_requests{ 0 };
+  std::atomic<int> m_num_coalesced_groups{ 0 };
   std::atomic<int> m_rawq_timeout_count{ 0 };
   std::atomic<int> m_stats_packet_count{ 0 };
   std::atomic<int> m_num_payloads_overwritten{ 0 };
 
   // CONSUMER
-  ReusableThread m_consumer_thread;
+  std::unique_ptr<ReusableThread> m_consumer_thread;
 
   // RAW SOURCE
   std::chrono::milliseconds m_source_queue_timeout_ms;
+  size_t m_consume_batch_size = 1;
   using raw_source_qt = appfwk::DAQSource<ReadoutType>;
   std::unique_ptr<raw_source_qt> m_raw_data_source;
 
@@ -375,6 +561,10 @@ private:
   std::chrono::milliseconds m_request_queue_timeout_ms;
   using request_source_qt = appfwk::DAQSource<dfmessages::DataRequest>;
   std::vector<std::unique_ptr<request_source_qt>> m_data_request_queues;
+  std::chrono::microseconds m_request_coalescing_time{ 0 };
+  // Requests are pushed from outside the package, so parking only times out
+  WaitStrategy m_request_wait{ std::chrono::milliseconds(10) };
+  request_list_t m_queued_requests; // Grouped mode only
 
   // FRAGMENT SINKS
   std::chrono::milliseconds m_fragment_queue_timeout_ms;
@@ -383,13 +573,14 @@ private:
 
   // LATENCY BUFFER:
   std::unique_ptr<LatencyBufferType> m_latency_buffer_impl;
+  std::unique_ptr<ReadoutType> m_overflow_payload; // Sink for payloads that don't fit into a full LB
 
   // RAW PROCESSING:
   std::unique_ptr<RawDataProcessorType> m_raw_processor_impl;
 
   // REQUEST HANDLER:
   std::unique_ptr<RequestHandlerType> m_request_handler_impl;
-  ReusableThread m_requester_thread;
+  std::unique_ptr<ReusableThread> m_requester_thread;
 
   std::unique_ptr<FrameErrorRegistry> m_error_registry;
 
@@ -397,7 +588,8 @@ private:
   std::chrono::milliseconds m_timesync_queue_timeout_ms;
   using timesync_sink_qt = appfwk::DAQSink<dfmessages::TimeSync>;
   std::unique_ptr<timesync_sink_qt> m_timesync_sink;
-  ReusableThread m_timesync_thread;
+  bool m_invalid_timesync_reported = false;
+  std::unique_ptr<ReusableThread> m_timesync_thread;
 
   std::chrono::time_point<std::chrono::high_resolution_clock> m_t0;
 };
@@ -90,6 +90,11 @@ public:
 
   void flush() override { pop(occupancy()); }
 
+  void get_info(opmonlib::InfoCollector& /*ci*/, int /*level*/) override
+  {
+    // No allocation stats for the SkipList, nodes are allocated one by one
+  }
+
   std::shared_ptr<SkipListT>& get_skip_list() { return std::ref(m_skip_list); }
 
   // For the continous buffer, the data is moved into the Folly queue.
@@ -104,6 +109,35 @@ public:
     return success;
   }
 
+  size_t write_n(T* new_elements, size_t num) override
+  {
+    size_t written = 0;
+    {
+      SkipListTAcc acc(m_skip_list);
+      for (size_t i = 0; i < num; ++i) {
+        if (acc.insert(std::move(new_elements[i])).second) {
+          ++written;
+        }
+      }
+    }
+    return written;
+  }
+
+  // Nodes are not contiguous, so elements are staged and inserted on commit
+  size_t reserve(T*& span, size_t num) override
+  {
+    if (num > m_staging_capacity) {
+      m_staging.reset(new T[num]);
+      m_staging_capacity = num;
+    }
+    span = m_staging.get();
+    return num;
+  }
+
+  size_t commit(size_t num) override { return write_n(m_staging.get(), num); }
+
+  bool commits_in_place() const override { return false; }
+
   bool put(T& new_element) // override
   {
     bool success = false;
@@ -143,6 +177,17 @@ public:
     return std::move(Iterator(std::move(acc), iter));
   }
 
+  // Number of elements older than the one the iterator points to, the list has to be walked
+  std::size_t elements_before(Iterator& iter)
+  {
+    std::size_t count = 0;
+    auto last = end();
+    for (auto it = begin(); it != iter && it != last; ++it) {
+      count++;
+    }
+    return count;
+  }
+
   Iterator lower_bound(T& element, bool /*with_errors=false*/)
   {
     SkipListTAcc acc = SkipListTAcc(m_skip_list);
@@ -176,6 +221,10 @@ private:
   // Concurrent SkipList
   std::shared_ptr<SkipListT> m_skip_list;
 
+  // Staging area for reserve/commit
+  std::unique_ptr<T[]> m_staging;
+  size_t m_staging_capacity = 0;
+
   // Conf
   static constexpr uint32_t unconfigured_head_height = 2; // NOLINT(build/unsigned)
 };
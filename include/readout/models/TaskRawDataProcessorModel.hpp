@@ -17,9 +17,11 @@
 #include "readout/concepts/RawDataProcessorConcept.hpp"
 #include "readout/readoutconfig/Nljs.hpp"
 #include "readout/utils/ReusableThread.hpp"
+#include "readout/utils/SpmcRing.hpp"
+#include "readout/utils/WaitStrategy.hpp"
+#include "readout/utils/WorkStealingExecutor.hpp"
 
-#include <folly/ProducerConsumerQueue.h>
-
+#include <algorithm>
 #include <chrono>
 #include <functional>
 #include <future>
@@ -49,17 +51,53 @@ public:
     auto config = cfg["rawdataprocessorconf"].get<readoutconfig::RawDataProcessorConf>();
     m_emulator_mode = config.emulator_mode;
     m_postprocess_queue_sizes = config.postprocess_queue_sizes;
+    m_postprocess_span_size = static_cast<size_t>(std::max(1, config.postprocess_span_size));
     m_this_link_number = config.element_id;
-
-    for (size_t i = 0; i < m_post_process_functions.size(); ++i) {
-      m_items_to_postprocess_queues.push_back(
-        std::make_unique<folly::ProducerConsumerQueue<const ReadoutType*>>(m_postprocess_queue_sizes));
-      m_post_process_threads.back()->set_name("postprocess-" + std::to_string(i), m_this_link_number);
-    }
-
     m_geoid.element_id = config.element_id;
     m_geoid.region_id = config.region_id;
     m_geoid.system_type = ReadoutType::system_type;
+    auto affinity = cfg["threadaffinityconf"].get<readoutconfig::ThreadAffinityConf>();
+    auto postprocess_cpus = resolve_cpus(affinity.postprocess_cpus, affinity.cpus, affinity.numa_node);
+
+    auto pool_threads = static_cast<size_t>(std::max(0, config.tpg_pool_threads));
+    bool use_pool =
+      pool_threads > 0 && std::count(m_postprocess_pooled.begin(), m_postprocess_pooled.end(), true) > 0;
+    if (use_pool &&
+        !WorkStealingExecutor::instance().start(pool_threads, resolve_cpus(affinity.tpg_pool_cpus, "", -1))) {
+      ers::warning(ConfigurationError(ERS_HERE,
+                                      m_geoid,
+                                      "The shared TPG pool runs with " +
+                                        std::to_string(WorkStealingExecutor::instance().num_threads()) +
+                                        " threads, or its threads could not be placed"));
+    }
+
+    if (!m_post_process_functions.empty()) {
+      m_postprocess_ring =
+        std::make_unique<SpmcRing<postprocess_span_t>>(m_postprocess_queue_sizes, m_post_process_functions.size());
+    }
+    // A new conf replaces what the previous one set up, start() picks them by task index
+    m_postprocess_strands.clear();
+    m_postprocess_strands.resize(m_post_process_functions.size());
+    m_postprocess_waits.clear();
+    for (size_t i = 0; i < m_post_process_functions.size(); ++i) {
+      m_postprocess_waits.push_back(std::make_unique<WaitStrategy>(s_postprocess_sleep_time));
+      if (!m_postprocess_waits.back()->set_mode(config.postprocess_wait_strategy)) {
+        ers::warning(ConfigurationError(
+          ERS_HERE, m_geoid, "Unknown postprocess_wait_strategy " + config.postprocess_wait_strategy + ", sleeping"));
+      }
+      if (use_pool && m_postprocess_pooled[i]) {
+        m_postprocess_strands[i] = WorkStealingExecutor::instance().make_strand(
+          [this, i]() { return run_post_processing_strand(m_post_process_functions[i], i); });
+        continue;
+      }
+      if (m_post_process_threads[i] == nullptr) {
+        m_post_process_threads[i] = std::make_unique<ReusableThread>(0);
+      }
+      m_post_process_threads[i]->set_name("postprocess-" + std::to_string(i), m_this_link_number);
+      if (!m_post_process_threads[i]->set_affinity(postprocess_cpus)) {
+        ers::warning(ConfigurationError(ERS_HERE, m_geoid, "Could not set the CPU affinity of the postprocess threads"));
+      }
+    }
   }
 
   void start(const nlohmann::json& /*args*/) override
@@ -68,18 +106,33 @@ public:
     // std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
     m_run_marker.store(true);
     for (size_t i = 0; i < m_post_process_threads.size(); ++i) {
+      if (m_postprocess_strands[i] != nullptr) {
+        continue;
+      }
       m_post_process_threads[i]->set_work(&TaskRawDataProcessorModel<ReadoutType>::run_post_processing_thread,
                                           this,
                                           std::ref(m_post_process_functions[i]),
-                                          std::ref(*m_items_to_postprocess_queues[i]));
+                                          i,
+                                          std::ref(*m_postprocess_waits[i]));
     }
   }
 
   void stop(const nlohmann::json& /*args*/) override
   {
     m_run_marker.store(false);
-    for (auto& thread : m_post_process_threads) {
-      while (!thread->get_readiness()) {
+    for (auto& wait : m_postprocess_waits) {
+      wait->notify_all();
+    }
+    for (size_t i = 0; i < m_post_process_threads.size(); ++i) {
+      if (m_postprocess_strands[i] != nullptr) {
+        // The pool works off what is still queued for this link
+        m_postprocess_strands[i]->notify();
+        while (!m_postprocess_ring->empty(i) || !m_postprocess_strands[i]->idle()) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        continue;
+      }
+      while (!m_post_process_threads[i]->get_readiness()) {
         std::this_thread::sleep_for(std::chrono::milliseconds(50));
       }
     }
@@ -96,26 +149,61 @@ public:
 
   void preprocess_item(ReadoutType* item) override { invoke_all_preprocess_functions(item); }
 
-  void postprocess_item(const ReadoutType* item) override
+  void postprocess_item(const ReadoutType* item) override { postprocess_items(item, 1); }
+
+  // One ring entry per span for all postprocess tasks, each walks the elements itself
+  void postprocess_items(const ReadoutType* items, std::size_t count) override
   {
-    for (size_t i = 0; i < m_items_to_postprocess_queues.size(); ++i) {
-      if (!m_items_to_postprocess_queues[i]->write(item)) {
-        ers::warning(PostprocessingNotKeepingUp(ERS_HERE, m_geoid, i));
+    if (m_postprocess_ring == nullptr) {
+      return;
+    }
+    if (!m_postprocess_ring->try_write({ items, count }, items->get_first_timestamp())) {
+      ers::warning(PostprocessingNotKeepingUp(ERS_HERE, m_geoid, m_postprocess_ring->slowest_consumer()));
+    }
+    for (auto& wait : m_postprocess_waits) {
+      wait->notify();
+    }
+    for (auto& strand : m_postprocess_strands) {
+      if (strand != nullptr) {
+        strand->notify();
       }
     }
   }
 
+  // The elements of the spans that a postprocess task has not finished yet
+  std::uint64_t get_oldest_unprocessed_timestamp() override // NOLINT(build/unsigned)
+  {
+    return m_postprocess_ring == nullptr ? SpmcRing<postprocess_span_t>::s_no_stamp
+                                         : m_postprocess_ring->oldest_pending_stamp();
+  }
+
+  // Tasks registered at run time, e.g. by plugins. Processors with fixed stages run them through
+  // a FramePipeline in their preprocess_item and call this one after it.
   template<typename Task>
   void add_preprocess_task(Task&& task)
   {
     m_preprocess_functions.push_back(std::forward<Task>(task));
   }
 
+  //! Task called once per element
   template<typename Task>
   void add_postprocess_task(Task&& task)
   {
-    m_post_process_threads.emplace_back(std::make_unique<ReusableThread>(0));
+    add_postprocess_span_task([task = std::forward<Task>(task)](const ReadoutType* items, std::size_t count) {
+      for (std::size_t i = 0; i < count; ++i) {
+        task(items + i);
+      }
+    });
+  }
+
+  //! Task called with up to postprocess_span_size consecutive elements at once.
+  //! A pooled task runs on the process-wide TPG pool when tpg_pool_threads is set, else on a thread of its own.
+  template<typename Task>
+  void add_postprocess_span_task(Task&& task, bool pooled = false)
+  {
+    m_post_process_threads.emplace_back(nullptr);
     m_post_process_functions.push_back(std::forward<Task>(task));
+    m_postprocess_pooled.push_back(pooled);
   }
 
   void invoke_all_preprocess_functions(ReadoutType* item)
@@ -133,17 +221,60 @@ public:
   }
 
 protected:
-  void run_post_processing_thread(std::function<void(const ReadoutType*)>& function,
-                                  folly::ProducerConsumerQueue<const ReadoutType*>& queue)
+  struct postprocess_span_t
+  {
+    const ReadoutType* items;
+    std::size_t count;
+  };
+
+  // Returns false when nothing was queued for the consumer
+  bool process_next_span(std::function<void(const ReadoutType*, std::size_t)>& function, std::size_t consumer)
+  {
+    auto& ring = *m_postprocess_ring;
+    postprocess_span_t span;
+    if (!ring.try_read(consumer, span)) {
+      return false;
+    }
+    // Queued spans that continue this one in the latency buffer are merged into it
+    std::size_t entries = 1;
+    postprocess_span_t next;
+    while (span.count < m_postprocess_span_size && ring.try_peek(consumer, entries, next) &&
+           next.items == span.items + span.count) {
+      span.count += next.count;
+      ++entries;
+    }
+    // A span may exceed the size by the last merged entry, it is handed over in slices
+    for (std::size_t offset = 0; offset < span.count; offset += m_postprocess_span_size) {
+      function(span.items + offset, std::min(m_postprocess_span_size, span.count - offset));
+    }
+    // Releases the spans for the cleanup of the latency buffer
+    ring.advance(consumer, entries);
+    return true;
+  }
+
+  void run_post_processing_thread(std::function<void(const ReadoutType*, std::size_t)>& function,
+                                  std::size_t consumer,
+                                  WaitStrategy& wait)
+  {
+    auto& ring = *m_postprocess_ring;
+    while (m_run_marker.load() || !ring.empty(consumer)) {
+      if (!process_next_span(function, consumer)) {
+        wait.wait([&]() { return !ring.empty(consumer) || !m_run_marker.load(); });
+      }
+    }
+  }
+
+  // A turn of the link on the shared pool. Returns true when spans are left, the pool then
+  // gives the other links a turn before this one continues.
+  bool run_post_processing_strand(std::function<void(const ReadoutType*, std::size_t)>& function,
+                                  std::size_t consumer)
   {
-    while (m_run_marker.load() || queue.sizeGuess() > 0) {
-      const ReadoutType* element;
-      if (queue.read(element)) {
-        function(element);
-      } else {
-        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    for (std::size_t i = 0; i < s_strand_spans_per_turn; ++i) {
+      if (!process_next_span(function, consumer)) {
+        return false;
       }
     }
+    return true;
   }
 
   std::atomic<bool> m_run_marker{ false };
@@ -151,11 +282,18 @@ protected:
   std::vector<std::function<void(ReadoutType*)>> m_preprocess_functions;
   std::unique_ptr<FrameErrorRegistry>& m_error_registry;
 
-  std::vector<std::function<void(const ReadoutType*)>> m_post_process_functions;
-  std::vector<std::unique_ptr<folly::ProducerConsumerQueue<const ReadoutType*>>> m_items_to_postprocess_queues;
+  std::vector<std::function<void(const ReadoutType*, std::size_t)>> m_post_process_functions;
+  std::unique_ptr<SpmcRing<postprocess_span_t>> m_postprocess_ring;
   std::vector<std::unique_ptr<ReusableThread>> m_post_process_threads;
+  std::vector<std::unique_ptr<WaitStrategy>> m_postprocess_waits;
+  // Pooled tasks have a strand on the shared pool instead of a thread
+  std::vector<bool> m_postprocess_pooled;
+  std::vector<std::unique_ptr<WorkStealingExecutor::Strand>> m_postprocess_strands;
+  static constexpr std::chrono::microseconds s_postprocess_sleep_time{ 50 };
+  static constexpr std::size_t s_strand_spans_per_turn = 16;
 
   size_t m_postprocess_queue_sizes;
+  size_t m_postprocess_span_size = 1;
   uint32_t m_this_link_number; // NOLINT(build/unsigned)
   daqdataformats::GeoID m_geoid;
   bool m_emulator_mode{ false };
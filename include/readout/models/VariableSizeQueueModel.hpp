@@ -0,0 +1,372 @@
+/**
+ * @file VariableSizeQueueModel.hpp Latency buffer storing variable size elements
+ * back to back in a contiguous byte ring, with a timestamp index on the side
+ *
+ * This is part of the DUNE DAQ , copyright 2021.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef READOUT_INCLUDE_READOUT_MODELS_VARIABLESIZEQUEUEMODEL_HPP_
+#define READOUT_INCLUDE_READOUT_MODELS_VARIABLESIZEQUEUEMODEL_HPP_
+
+#include "readout/ReadoutIssues.hpp"
+#include "readout/ReadoutLogging.hpp"
+#include "readout/concepts/LatencyBufferConcept.hpp"
+#include "readout/readoutconfig/Nljs.hpp"
+#include "readout/readoutconfig/Structs.hpp"
+#include "readout/readoutinfo/InfoNljs.hpp"
+
+#include "logging/Logging.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <unistd.h>
+#include <utility>
+
+using dunedaq::readout::logging::TLVL_WORK_STEPS;
+
+namespace dunedaq {
+namespace readout {
+
+/**
+ * How elements of type T are laid out in the byte ring. The default is for types whose first
+ * get_payload_size() bytes are a valid prefix of the object (e.g. a message in a fixed size array).
+ * Types owning their payload through a pointer need a specialization.
+ * */
+template<class T>
+struct VariableSizeElementTraits
+{
+  //! Ring bytes per element when latency_buffer_byte_size is not configured, the largest element by default
+  static constexpr std::size_t default_element_bytes = sizeof(T);
+
+  //! Amount of bytes the element takes in the ring
+  static std::size_t stored_size(T& element) { return element.get_payload_size(); }
+
+  //! Copy the element into the ring, dest holds stored_size(element) bytes
+  static void store(T& element, char* dest)
+  {
+    std::memcpy(dest, static_cast<void*>(&element), element.get_payload_size());
+  }
+
+  //! Element view on stored bytes
+  static T* view(char* stored) { return reinterpret_cast<T*>(stored); } // NOLINT
+
+  //! Copy a stored element out of the ring
+  static void load(char* stored, std::size_t size, T& element)
+  {
+    std::memcpy(static_cast<void*>(&element), stored, size);
+  }
+
+  //! Undo what store() set up, before the bytes are reused
+  static void release(char* /*stored*/) {}
+};
+
+template<class T>
+class VariableSizeQueueModel : public LatencyBufferConcept<T>
+{
+public:
+  using Traits = VariableSizeElementTraits<T>;
+
+  // Alignment of the stored elements
+  static constexpr std::size_t s_record_alignment = 16;
+
+  VariableSizeQueueModel()
+    : LatencyBufferConcept<T>()
+  {
+    TLOG(TLVL_WORK_STEPS) << "Initializing non configured latency buffer";
+  }
+
+  VariableSizeQueueModel(std::size_t max_elements, std::size_t byte_size)
+    : LatencyBufferConcept<T>()
+  {
+    allocate_memory(max_elements, byte_size);
+  }
+
+  ~VariableSizeQueueModel() { free_memory(); }
+
+  struct Iterator
+  {
+    using iterator_category = std::forward_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = T;
+    using pointer = T*;
+    using reference = T&;
+
+    Iterator(VariableSizeQueueModel<T>& queue, uint64_t seq) // NOLINT(build/unsigned)
+      : m_queue(queue)
+      , m_seq(seq)
+    {}
+
+    reference operator*() const { return *m_queue.element_at(m_seq); }
+    pointer operator->() { return m_queue.element_at(m_seq); }
+    Iterator& operator++() // NOLINT(runtime/increment_decrement) :)
+    {
+      if (good()) {
+        m_seq++;
+      }
+      if (!good()) {
+        m_seq = s_end_seq;
+      }
+      return *this;
+    }
+
+    friend bool operator==(const Iterator& a, const Iterator& b) { return a.m_seq == b.m_seq; }
+    friend bool operator!=(const Iterator& a, const Iterator& b) { return a.m_seq != b.m_seq; }
+
+    uint64_t get_seq() const { return m_seq; } // NOLINT(build/unsigned)
+
+    bool good()
+    {
+      return m_seq != s_end_seq && m_seq >= m_queue.m_read_seq.load(std::memory_order_relaxed) &&
+             m_seq < m_queue.m_write_seq.load(std::memory_order_acquire);
+    }
+
+  private:
+    VariableSizeQueueModel<T>& m_queue;
+    uint64_t m_seq; // NOLINT(build/unsigned)
+  };
+
+  void conf(const nlohmann::json& cfg) override
+  {
+    auto conf = cfg["latencybufferconf"].get<readoutconfig::LatencyBufferConf>();
+    free_memory();
+    // Without a byte size every element gets the room its type asks for, aligned as stored in the ring
+    std::size_t element_bytes =
+      (Traits::default_element_bytes + s_record_alignment - 1) / s_record_alignment * s_record_alignment;
+    std::size_t byte_size = conf.latency_buffer_byte_size != 0 ? conf.latency_buffer_byte_size
+                                                               : conf.latency_buffer_size * element_bytes;
+    allocate_memory(conf.latency_buffer_size, byte_size);
+    if (!m_buffer || !m_records) {
+      throw std::bad_alloc();
+    }
+  }
+
+  std::size_t occupancy() const override
+  {
+    return m_write_seq.load(std::memory_order_acquire) - m_read_seq.load(std::memory_order_acquire);
+  }
+
+  bool write(T&& element) override
+  {
+    if (!store_element(element)) {
+      ++m_overflow_ctr;
+      return false;
+    }
+    m_write_seq.store(m_write_seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    return true;
+  }
+
+  std::size_t write_n(T* elements, std::size_t amount) override
+  {
+    auto const current_write = m_write_seq.load(std::memory_order_relaxed);
+    std::size_t written = 0;
+    while (written < amount && store_element(elements[written], current_write + written)) {
+      ++written;
+    }
+    if (written > 0) {
+      m_write_seq.store(current_write + written, std::memory_order_release);
+    }
+    m_overflow_ctr += amount - written;
+    return written;
+  }
+
+  // Elements are copied into the ring on commit, only their real size is copied
+  std::size_t reserve(T*& span, std::size_t amount) override
+  {
+    if (amount > m_staging_capacity) {
+      m_staging.reset(new T[amount]);
+      m_staging_capacity = amount;
+    }
+    span = m_staging.get();
+    return amount;
+  }
+
+  std::size_t commit(std::size_t amount) override { return write_n(m_staging.get(), amount); }
+
+  bool commits_in_place() const override { return false; }
+
+  bool read(T& element) override
+  {
+    auto const current_read = m_read_seq.load(std::memory_order_relaxed);
+    if (current_read == m_write_seq.load(std::memory_order_acquire)) {
+      return false;
+    }
+    auto& record = m_records[current_read % m_max_elements];
+    char* stored = m_buffer + record.offset % m_byte_size;
+    Traits::load(stored, record.size, element);
+    Traits::release(stored);
+    m_read_seq.store(current_read + 1, std::memory_order_release);
+    return true;
+  }
+
+  const T* front() override
+  {
+    auto const current_read = m_read_seq.load(std::memory_order_relaxed);
+    if (current_read == m_write_seq.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    return element_at(current_read);
+  }
+
+  const T* back() override
+  {
+    auto const current_write = m_write_seq.load(std::memory_order_acquire);
+    if (current_write == m_read_seq.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    return element_at(current_write - 1);
+  }
+
+  void pop(std::size_t amount) override
+  {
+    auto const current_read = m_read_seq.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < amount; ++i) {
+      auto& record = m_records[(current_read + i) % m_max_elements];
+      Traits::release(m_buffer + record.offset % m_byte_size);
+    }
+    m_read_seq.store(current_read + amount, std::memory_order_release);
+  }
+
+  void flush() override { pop(occupancy()); }
+
+  Iterator begin()
+  {
+    auto const current_read = m_read_seq.load(std::memory_order_relaxed);
+    if (current_read == m_write_seq.load(std::memory_order_acquire)) {
+      return end();
+    }
+    return Iterator(*this, current_read);
+  }
+
+  Iterator end() { return Iterator(*this, s_end_seq); }
+
+  // Number of elements older than the one the iterator points to
+  std::size_t elements_before(const Iterator& iter)
+  {
+    if (iter.get_seq() == s_end_seq) {
+      return occupancy();
+    }
+    return iter.get_seq() - m_read_seq.load(std::memory_order_relaxed);
+  }
+
+  // Element covering the timestamp of the given element, like the iterable models: the first one with
+  // exactly that timestamp, otherwise the last older one. end() when all elements are newer.
+  Iterator lower_bound(T& element, bool /*with_errors=false*/)
+  {
+    uint64_t timestamp = element.get_first_timestamp();          // NOLINT(build/unsigned)
+    uint64_t const begin = m_read_seq.load(std::memory_order_relaxed); // NOLINT(build/unsigned)
+    uint64_t const end = m_write_seq.load(std::memory_order_acquire);  // NOLINT(build/unsigned)
+    uint64_t first = begin; // NOLINT(build/unsigned)
+    uint64_t last = end;    // NOLINT(build/unsigned)
+    while (first < last) {
+      uint64_t middle = first + (last - first) / 2; // NOLINT(build/unsigned)
+      if (m_records[middle % m_max_elements].timestamp < timestamp) {
+        first = middle + 1;
+      } else {
+        last = middle;
+      }
+    }
+    if (first < end && m_records[first % m_max_elements].timestamp == timestamp) {
+      return Iterator(*this, first);
+    }
+    if (first == begin) {
+      return this->end();
+    }
+    return Iterator(*this, first - 1);
+  }
+
+  void get_info(opmonlib::InfoCollector& ci, int /*level*/) override
+  {
+    readoutinfo::LatencyBufferInfo info;
+    info.page_size = sysconf(_SC_PAGESIZE);
+    info.transparent_huge_pages = false;
+    info.allocated_bytes = m_byte_size + m_max_elements * sizeof(Record);
+    ci.add(info);
+  }
+
+protected:
+  // Entry of the timestamp index, one per stored element
+  struct Record
+  {
+    uint64_t offset;    // NOLINT(build/unsigned)
+    uint64_t timestamp; // NOLINT(build/unsigned)
+    std::size_t size;
+  };
+
+  static constexpr uint64_t s_end_seq = std::numeric_limits<uint64_t>::max(); // NOLINT(build/unsigned)
+
+  void allocate_memory(std::size_t max_elements, std::size_t byte_size)
+  {
+    // Offsets are kept aligned across the wrap around
+    m_byte_size = byte_size / s_record_alignment * s_record_alignment;
+    m_max_elements = max_elements;
+    m_buffer = static_cast<char*>(std::aligned_alloc(s_record_alignment, m_byte_size));
+    m_records.reset(new Record[max_elements]);
+    m_read_seq = 0;
+    m_write_seq = 0;
+    m_write_offset = 0;
+  }
+
+  void free_memory()
+  {
+    if (m_buffer) {
+      flush();
+      std::free(m_buffer);
+      m_buffer = nullptr;
+    }
+  }
+
+  T* element_at(uint64_t seq) // NOLINT(build/unsigned)
+  {
+    return Traits::view(m_buffer + m_records[seq % m_max_elements].offset % m_byte_size);
+  }
+
+  // Copy the element behind the last written one, without publishing it
+  bool store_element(T& element, uint64_t seq) // NOLINT(build/unsigned)
+  {
+    auto const current_read = m_read_seq.load(std::memory_order_acquire);
+    if (seq - current_read >= m_max_elements) {
+      return false;
+    }
+    std::size_t size = Traits::stored_size(element);
+    uint64_t offset = (m_write_offset + s_record_alignment - 1) / s_record_alignment * s_record_alignment; // NOLINT
+    if (offset % m_byte_size + size > m_byte_size) {
+      // Elements never wrap around, they start over at the beginning of the ring
+      offset = (offset / m_byte_size + 1) * m_byte_size;
+    }
+    uint64_t tail = seq == current_read ? offset : m_records[current_read % m_max_elements].offset; // NOLINT
+    if (size > m_byte_size || offset + size - tail > m_byte_size) {
+      return false;
+    }
+    Traits::store(element, m_buffer + offset % m_byte_size);
+    m_records[seq % m_max_elements] = { offset, element.get_first_timestamp(), size };
+    m_write_offset = offset + size;
+    return true;
+  }
+
+  bool store_element(T& element) { return store_element(element, m_write_seq.load(std::memory_order_relaxed)); }
+
+  char* m_buffer = nullptr;
+  std::size_t m_byte_size = 0;
+  std::unique_ptr<Record[]> m_records;
+  std::size_t m_max_elements = 0;
+
+  std::atomic<uint64_t> m_read_seq{ 0 };  // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_write_seq{ 0 }; // NOLINT(build/unsigned)
+  uint64_t m_write_offset = 0;            // NOLINT(build/unsigned)
+  std::atomic<int> m_overflow_ctr{ 0 };
+
+  // Staging area for reserve/commit
+  std::unique_ptr<T[]> m_staging;
+  std::size_t m_staging_capacity = 0;
+};
+
+} // namespace readout
+} // namespace dunedaq
+
+#endif // READOUT_INCLUDE_READOUT_MODELS_VARIABLESIZEQUEUEMODEL_HPP_
@@ -62,7 +62,7 @@ namespace dunedaq {
           ers::error(CommandError(ERS_HERE, inherited::m_geoid, "A recording is still running, no new recording was started!"));
           return;
         }        
-        inherited::m_recording_thread.set_work(
+        inherited::recording_thread().set_work(
             [&](int duration) {
               size_t chunk_size = inherited::m_stream_buffer_size;
               size_t alignment_size = inherited::m_latency_buffer->get_alignment_size();
@@ -80,21 +80,17 @@ namespace dunedaq {
               size_t bytes_written = 0;
 
               while (std::chrono::duration_cast<std::chrono::seconds>(current_time - start_of_recording).count() < duration) {
-                if (!inherited::m_cleanup_requested || (inherited::m_next_timestamp_to_record == 0)) {
+                {
                   size_t considered_chunks_in_loop = 0;
 
-                  // Wait for potential running cleanup to finish first
-                  {
-                    std::unique_lock<std::mutex> lock(inherited::m_cv_mutex);
-                    inherited::m_cv.wait(lock, [&] { return !inherited::m_cleanup_requested; });
-                  }
-                  inherited::m_cv.notify_all();
-
                   // Some frames have to be skipped to start copying from an aligned piece of memory
                   // These frames cannot be written without O_DIRECT as this would mess up the alignment of the write pointer into the target file
                   if (inherited::m_next_timestamp_to_record == 0) {
+                    // Hold the whole buffer until the recorded timestamp protects the elements
+                    auto reader_slot = inherited::enter_reader(0);
                     auto begin = inherited::m_latency_buffer->begin();
                     if (begin == inherited::m_latency_buffer->end()) {
+                        inherited::exit_reader(reader_slot);
                         // There are no elements in the buffer, update time and try again
                         current_time = std::chrono::high_resolution_clock::now();
                         continue;
@@ -112,6 +108,7 @@ namespace dunedaq {
                             continue;
                         }
                     }
+                    inherited::exit_reader(reader_slot);
                     TLOG() << "Skipped " << skipped_frames << " frames";
                     current_write_pointer = reinterpret_cast<const char*>(&(*begin));
                   }
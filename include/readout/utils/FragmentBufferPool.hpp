@@ -0,0 +1,229 @@
+/**
+ * @file FragmentBufferPool.hpp Size class pool of fragment buffers
+ * Fragments take over their buffer and free() it downstream, so buffers can not
+ * be recycled. The pool keeps pre-faulted buffers ready instead, so that the request
+ * threads neither call malloc nor fault in pages for them. The buffers are allocated
+ * by one refill thread per pool, which does not compete with the request threads.
+ * Every power of two range is split in s_sub_buckets classes, a buffer is at most
+ * a quarter bigger than the fragment it holds.
+ *
+ * This is part of the DUNE DAQ , copyright 2021.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef READOUT_INCLUDE_READOUT_UTILS_FRAGMENTBUFFERPOOL_HPP_
+#define READOUT_INCLUDE_READOUT_UTILS_FRAGMENTBUFFERPOOL_HPP_
+
+#include "daqdataformats/Fragment.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace readout {
+
+class FragmentBufferPool
+{
+public:
+  // Size classes from 4 kB up to 16 MB, s_sub_buckets of them per power of two
+  static constexpr std::size_t s_min_class_shift = 12;
+  static constexpr std::size_t s_sub_bucket_bits = 2;
+  static constexpr std::size_t s_sub_buckets = std::size_t(1) << s_sub_bucket_bits;
+  static constexpr std::size_t s_num_classes = 12 * s_sub_buckets + 1;
+  // Stride of the writes that fault in new buffers
+  static constexpr std::size_t s_page_size = 4096;
+
+  FragmentBufferPool() = default;
+
+  ~FragmentBufferPool() { clear(); }
+
+  FragmentBufferPool(const FragmentBufferPool&) = delete;            ///< FragmentBufferPool is not copy-constructible
+  FragmentBufferPool& operator=(const FragmentBufferPool&) = delete; ///< FragmentBufferPool is not copy-assignable
+  FragmentBufferPool(FragmentBufferPool&&) = delete;                 ///< FragmentBufferPool is not move-constructible
+  FragmentBufferPool& operator=(FragmentBufferPool&&) = delete;      ///< FragmentBufferPool is not move-assignable
+
+  //! Number of ready buffers kept per size class, 0 disables the pool
+  void set_depth(std::size_t depth)
+  {
+    m_depth = depth;
+    if (depth == 0) {
+      clear();
+    }
+  }
+
+  //! Bytes the ready buffers of all size classes may take together
+  void set_capacity(std::size_t bytes) { m_capacity = bytes; }
+
+  std::size_t get_depth() const { return m_depth; }
+
+  //! Buffer of at least size bytes, to be released with free()
+  void* acquire(std::size_t size)
+  {
+    auto size_class = class_of(size);
+    if (m_depth != 0 && size_class < s_num_classes) {
+      auto& pool = m_classes[size_class];
+      pool.requested.store(true, std::memory_order_relaxed);
+      void* buffer = nullptr;
+      {
+        std::lock_guard<std::mutex> lock(pool.lock);
+        if (!pool.buffers.empty()) {
+          buffer = pool.buffers.back();
+          pool.buffers.pop_back();
+        }
+      }
+      if (buffer != nullptr) {
+        m_pooled_bytes -= class_size(size_class);
+      }
+      notify_refill();
+      if (buffer != nullptr) {
+        ++m_hits;
+        return buffer;
+      }
+    }
+    ++m_misses;
+    return std::malloc(size);
+  }
+
+  //! Copy the header and the pieces into a pooled buffer the fragment takes over
+  std::unique_ptr<daqdataformats::Fragment> make_fragment(const daqdataformats::FragmentHeader& header,
+                                                          const std::vector<std::pair<void*, size_t>>& pieces)
+  {
+    daqdataformats::FragmentHeader fragment_header = header;
+    fragment_header.size = sizeof(fragment_header);
+    for (auto& piece : pieces) {
+      fragment_header.size += piece.second;
+    }
+    char* buffer = static_cast<char*>(acquire(fragment_header.size));
+    if (buffer == nullptr) {
+      throw std::bad_alloc();
+    }
+    std::memcpy(buffer, &fragment_header, sizeof(fragment_header));
+    std::size_t offset = sizeof(fragment_header);
+    for (auto& piece : pieces) {
+      std::memcpy(buffer + offset, piece.first, piece.second);
+      offset += piece.second;
+    }
+    return std::make_unique<daqdataformats::Fragment>(buffer,
+                                                      daqdataformats::Fragment::BufferAdoptionMode::kTakeOverBuffer);
+  }
+
+  //! Bring the size classes in use back to depth, as far as the capacity allows. Called by the refill
+  //! thread only. The classes get one buffer per turn, so that the small ones do not take all of the
+  //! capacity. Only one byte per page of a new buffer is written: that faults in the pages malloc got
+  //! fresh from the kernel, and costs next to nothing on reused ones.
+  void refill()
+  {
+    bool added = true;
+    while (added && m_depth != 0) {
+      added = false;
+      for (std::size_t size_class = 0; size_class < s_num_classes; ++size_class) {
+        auto& pool = m_classes[size_class];
+        if (!pool.requested.load(std::memory_order_relaxed)) {
+          continue;
+        }
+        std::size_t bytes = class_size(size_class);
+        {
+          std::lock_guard<std::mutex> lock(pool.lock);
+          if (pool.buffers.size() >= m_depth) {
+            continue;
+          }
+        }
+        if (m_pooled_bytes + bytes > m_capacity) {
+          continue;
+        }
+        char* buffer = static_cast<char*>(std::malloc(bytes));
+        if (buffer == nullptr) {
+          return;
+        }
+        for (std::size_t offset = 0; offset < bytes; offset += s_page_size) {
+          buffer[offset] = 0;
+        }
+        m_pooled_bytes += bytes;
+        std::lock_guard<std::mutex> lock(pool.lock);
+        pool.buffers.push_back(buffer);
+        added = true;
+      }
+    }
+  }
+
+  //! Sleep until a buffer was taken or missed, or the timeout ran out
+  void wait_for_refill(std::chrono::milliseconds timeout)
+  {
+    std::unique_lock<std::mutex> lock(m_refill_lock);
+    m_refill_cv.wait_for(lock, timeout, [this]() { return m_refill_needed; });
+    m_refill_needed = false;
+  }
+
+  uint64_t get_and_reset_hits() { return m_hits.exchange(0); }     // NOLINT(build/unsigned)
+  uint64_t get_and_reset_misses() { return m_misses.exchange(0); } // NOLINT(build/unsigned)
+
+private:
+  struct SizeClass
+  {
+    std::mutex lock;
+    std::vector<void*> buffers;
+    std::atomic<bool> requested{ false };
+  };
+
+  // 4, 5, 6 and 7 kB, then 8, 10, 12 and 14 kB, and so on
+  static std::size_t class_size(std::size_t size_class)
+  {
+    return (s_sub_buckets + size_class % s_sub_buckets)
+           << (size_class / s_sub_buckets + s_min_class_shift - s_sub_bucket_bits);
+  }
+
+  static std::size_t class_of(std::size_t size)
+  {
+    std::size_t size_class = 0;
+    while (size_class < s_num_classes && class_size(size_class) < size) {
+      ++size_class;
+    }
+    return size_class;
+  }
+
+  void notify_refill()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_refill_lock);
+      m_refill_needed = true;
+    }
+    m_refill_cv.notify_one();
+  }
+
+  void clear()
+  {
+    for (auto& pool : m_classes) {
+      std::lock_guard<std::mutex> lock(pool.lock);
+      for (auto buffer : pool.buffers) {
+        std::free(buffer);
+      }
+      pool.buffers.clear();
+      pool.requested.store(false, std::memory_order_relaxed);
+    }
+    m_pooled_bytes = 0;
+  }
+
+  std::array<SizeClass, s_num_classes> m_classes;
+  std::atomic<std::size_t> m_depth{ 0 };
+  std::atomic<std::size_t> m_capacity{ 0 };
+  std::atomic<std::size_t> m_pooled_bytes{ 0 };
+  std::mutex m_refill_lock;
+  std::condition_variable m_refill_cv;
+  bool m_refill_needed = false;
+  std::atomic<uint64_t> m_hits{ 0 };   // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_misses{ 0 }; // NOLINT(build/unsigned)
+};
+
+} // namespace readout
+} // namespace dunedaq
+
+#endif // READOUT_INCLUDE_READOUT_UTILS_FRAGMENTBUFFERPOOL_HPP_
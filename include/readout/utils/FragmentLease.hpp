@@ -0,0 +1,77 @@
+/**
+ * @file FragmentLease.hpp Fragment pieces that still point into the latency buffer,
+ * together with the lease that keeps them from being cleaned up
+ *
+ * This is part of the DUNE DAQ , copyright 2021.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef READOUT_INCLUDE_READOUT_UTILS_FRAGMENTLEASE_HPP_
+#define READOUT_INCLUDE_READOUT_UTILS_FRAGMENTLEASE_HPP_
+
+#include "readout/utils/FragmentBufferPool.hpp"
+
+#include "daqdataformats/Fragment.hpp"
+
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace readout {
+
+class FragmentLease
+{
+public:
+  using pieces_t = std::vector<std::pair<void*, size_t>>;
+
+  FragmentLease(const daqdataformats::FragmentHeader& header, pieces_t&& pieces, std::function<void()> release)
+    : m_header(header)
+    , m_pieces(std::move(pieces))
+    , m_release(std::move(release))
+  {}
+
+  ~FragmentLease() { release(); }
+
+  FragmentLease(const FragmentLease&) = delete;            ///< FragmentLease is not copy-constructible
+  FragmentLease& operator=(const FragmentLease&) = delete; ///< FragmentLease is not copy-assignable
+  FragmentLease(FragmentLease&& other)
+    : m_header(other.m_header)
+    , m_pieces(std::move(other.m_pieces))
+    , m_release(std::move(other.m_release))
+  {
+    other.m_release = nullptr;
+  }
+  FragmentLease& operator=(FragmentLease&&) = delete; ///< FragmentLease is not move-assignable
+
+  const daqdataformats::FragmentHeader& get_header() const { return m_header; }
+  const pieces_t& get_pieces() const { return m_pieces; }
+
+  //! Copy the pieces into a self-contained fragment and give the lease back
+  std::unique_ptr<daqdataformats::Fragment> materialize(FragmentBufferPool& pool)
+  {
+    auto fragment = pool.make_fragment(m_header, m_pieces);
+    release();
+    return fragment;
+  }
+
+  //! The pieces must not be accessed anymore after this
+  void release()
+  {
+    if (m_release) {
+      m_release();
+      m_release = nullptr;
+    }
+  }
+
+private:
+  daqdataformats::FragmentHeader m_header;
+  pieces_t m_pieces;
+  std::function<void()> m_release;
+};
+
+} // namespace readout
+} // namespace dunedaq
+
+#endif // READOUT_INCLUDE_READOUT_UTILS_FRAGMENTLEASE_HPP_
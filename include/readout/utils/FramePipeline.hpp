@@ -0,0 +1,35 @@
+/**
+ * @file FramePipeline.hpp Preprocess stages that are known at compile time
+ * The stages are member functions of a processor, void (Processor::*)(FrameType* frame, std::size_t frame_index).
+ * They are called through constant member pointers, so they are inlined and fused into a single pass
+ * over the frames of an element: every frame header is loaded once for all stages.
+ *
+ * This is part of the DUNE DAQ , copyright 2021.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef READOUT_INCLUDE_READOUT_UTILS_FRAMEPIPELINE_HPP_
+#define READOUT_INCLUDE_READOUT_UTILS_FRAMEPIPELINE_HPP_
+
+#include <cstddef>
+
+namespace dunedaq {
+namespace readout {
+
+template<auto... Stages>
+struct FramePipeline
+{
+  //! Runs every stage on frame 0, then every stage on frame 1, and so on
+  template<class Processor, class FrameType>
+  static inline void run(Processor& processor, FrameType* frames, std::size_t num_frames)
+  {
+    for (std::size_t i = 0; i < num_frames; ++i) {
+      (..., (processor.*Stages)(frames + i, i));
+    }
+  }
+};
+
+} // namespace readout
+} // namespace dunedaq
+
+#endif // READOUT_INCLUDE_READOUT_UTILS_FRAMEPIPELINE_HPP_
@@ -0,0 +1,142 @@
+/**
+ * @file LatencyHistogram.hpp Lock-free log-linear (HDR style) histogram of latencies
+ * Every power of two range is split in s_sub_buckets / 2 buckets, so the reported
+ * percentiles are within 2/s_sub_buckets of the recorded values. Recording threads are
+ * spread over shards, so they do not contend on the same counters.
+ *
+ * This is part of the DUNE DAQ , copyright 2021.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef READOUT_INCLUDE_READOUT_UTILS_LATENCYHISTOGRAM_HPP_
+#define READOUT_INCLUDE_READOUT_UTILS_LATENCYHISTOGRAM_HPP_
+
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace dunedaq {
+namespace readout {
+
+class LatencyHistogram
+{
+public:
+  static constexpr unsigned s_sub_bucket_bits = 4;                   // NOLINT(build/unsigned)
+  static constexpr uint64_t s_sub_buckets = 1ULL << s_sub_bucket_bits; // NOLINT(build/unsigned)
+  // Values below 2^40 (about 18 minutes in ns) are told apart, bigger ones go to the last bucket
+  static constexpr unsigned s_max_value_bits = 40; // NOLINT(build/unsigned)
+  static constexpr std::size_t s_num_buckets = (s_max_value_bits - s_sub_bucket_bits + 2) * s_sub_buckets / 2;
+  static constexpr std::size_t s_num_shards = 8;
+
+  struct Summary
+  {
+    uint64_t count = 0; // NOLINT(build/unsigned)
+    uint64_t p50 = 0;   // NOLINT(build/unsigned)
+    uint64_t p99 = 0;   // NOLINT(build/unsigned)
+    uint64_t p999 = 0;  // NOLINT(build/unsigned)
+    uint64_t max = 0;   // NOLINT(build/unsigned)
+  };
+
+  LatencyHistogram() { reset(); }
+
+  void record(uint64_t value, uint64_t count = 1) // NOLINT(build/unsigned)
+  {
+    auto& shard = m_shards[shard_index()];
+    shard.buckets[bucket_of(value)].fetch_add(count, std::memory_order_relaxed);
+    auto max = shard.max.load(std::memory_order_relaxed);
+    while (value > max && !shard.max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    }
+  }
+
+  //! Percentiles of what was recorded since the last call
+  Summary get_and_reset()
+  {
+    std::vector<uint64_t> buckets(s_num_buckets, 0); // NOLINT(build/unsigned)
+    Summary summary;
+    for (auto& shard : m_shards) {
+      for (std::size_t i = 0; i < s_num_buckets; ++i) {
+        auto count = shard.buckets[i].exchange(0, std::memory_order_relaxed);
+        buckets[i] += count;
+        summary.count += count;
+      }
+      auto max = shard.max.exchange(0, std::memory_order_relaxed);
+      summary.max = max > summary.max ? max : summary.max;
+    }
+    summary.p50 = percentile(buckets, summary.count, 0.5, summary.max);
+    summary.p99 = percentile(buckets, summary.count, 0.99, summary.max);
+    summary.p999 = percentile(buckets, summary.count, 0.999, summary.max);
+    return summary;
+  }
+
+  void reset() { get_and_reset(); }
+
+private:
+  struct alignas(64) Shard
+  {
+    std::array<std::atomic<uint64_t>, s_num_buckets> buckets; // NOLINT(build/unsigned)
+    std::atomic<uint64_t> max;                                // NOLINT(build/unsigned)
+  };
+
+  static std::size_t shard_index()
+  {
+    static std::atomic<std::size_t> next_thread{ 0 };
+    static thread_local std::size_t thread_shard = next_thread.fetch_add(1) % s_num_shards;
+    return thread_shard;
+  }
+
+  // Values below s_sub_buckets have their own bucket, above that every power of two range
+  // has s_sub_buckets / 2 buckets
+  static std::size_t bucket_of(uint64_t value) // NOLINT(build/unsigned)
+  {
+    unsigned msb = 63 - __builtin_clzll(value | 1); // NOLINT(build/unsigned)
+    if (msb < s_sub_bucket_bits) {
+      return value;
+    }
+    unsigned shift = msb - s_sub_bucket_bits + 1; // NOLINT(build/unsigned)
+    std::size_t bucket = shift * (s_sub_buckets / 2) + (value >> shift);
+    return bucket < s_num_buckets ? bucket : s_num_buckets - 1;
+  }
+
+  // Highest value that falls in the bucket
+  static uint64_t bucket_top(std::size_t bucket) // NOLINT(build/unsigned)
+  {
+    if (bucket < s_sub_buckets) {
+      return bucket;
+    }
+    uint64_t shift = bucket / (s_sub_buckets / 2) - 1;   // NOLINT(build/unsigned)
+    uint64_t sub = bucket - shift * (s_sub_buckets / 2); // NOLINT(build/unsigned)
+    return ((sub + 1) << shift) - 1;
+  }
+
+  static uint64_t percentile(const std::vector<uint64_t>& buckets, // NOLINT(build/unsigned)
+                             uint64_t count,                       // NOLINT(build/unsigned)
+                             double fraction,
+                             uint64_t max) // NOLINT(build/unsigned)
+  {
+    if (count == 0) {
+      return 0;
+    }
+    // Nearest rank: the smallest value with at least fraction of the values at or below it
+    uint64_t rank = static_cast<uint64_t>(std::ceil(fraction * count)); // NOLINT(build/unsigned)
+    uint64_t seen = 0;                                                   // NOLINT(build/unsigned)
+    std::size_t i = 0;
+    for (; i < s_num_buckets - 1; ++i) {
+      seen += buckets[i];
+      if (seen >= rank && seen != 0) {
+        break;
+      }
+    }
+    // The last bucket is open ended
+    auto top = i < s_num_buckets - 1 ? bucket_top(i) : max;
+    return top < max ? top : max;
+  }
+
+  std::array<Shard, s_num_shards> m_shards;
+};
+
+} // namespace readout
+} // namespace dunedaq
+
+#endif // READOUT_INCLUDE_READOUT_UTILS_LATENCYHISTOGRAM_HPP_
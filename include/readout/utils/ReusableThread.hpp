@@ -11,6 +11,9 @@
 #ifndef READOUT_INCLUDE_READOUT_UTILS_REUSABLETHREAD_HPP_
 #define READOUT_INCLUDE_READOUT_UTILS_REUSABLETHREAD_HPP_
 
+#include <pthread.h>
+#include <sched.h>
+
 #include <atomic>
 #include <chrono>
 #include <condition_variable>
@@ -18,6 +21,9 @@
 #include <mutex>
 #include <string>
 #include <thread>
+#include <vector>
+
+#include "readout/utils/ThreadAffinity.hpp"
 
 namespace dunedaq {
 namespace readout {
@@ -68,6 +74,16 @@ public:
     pthread_setname_np(handle, tname);
   }
 
+  // Restrict the thread to the given CPUs, before it runs any task. An empty set leaves it as it is.
+  bool set_affinity(const std::vector<int>& cpus) { return set_thread_affinity(m_thread.native_handle(), cpus); }
+
+  // Run only when the CPUs of the thread have nothing else to do
+  bool set_idle_priority()
+  {
+    sched_param param{};
+    return pthread_setschedparam(m_thread.native_handle(), SCHED_IDLE, &param) == 0;
+  }
+
   // Check for completed task execution
   bool get_readiness() const { return m_task_executed; }
 
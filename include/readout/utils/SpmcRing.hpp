@@ -0,0 +1,176 @@
+/**
+ * @file SpmcRing.hpp Single producer, multiple consumer ring
+ * Every entry is written once and read by each consumer through its own read cursor.
+ * The producer only reuses a slot once the slowest consumer is done with it.
+ * Entries carry an ordered stamp (e.g. a timestamp), so that others can ask for the oldest
+ * entry that is still pending for some consumer.
+ *
+ * This is part of the DUNE DAQ , copyright 2021.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef READOUT_INCLUDE_READOUT_UTILS_SPMCRING_HPP_
+#define READOUT_INCLUDE_READOUT_UTILS_SPMCRING_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <type_traits>
+
+namespace dunedaq {
+namespace readout {
+
+template<class T>
+class SpmcRing
+{
+public:
+  static_assert(std::is_trivially_copyable<T>::value, "SpmcRing entries are copied between threads");
+
+  static constexpr uint64_t s_no_stamp = std::numeric_limits<uint64_t>::max(); // NOLINT(build/unsigned)
+
+  //! The capacity is rounded up to a power of two, there is at least one consumer
+  SpmcRing(std::size_t capacity, std::size_t num_consumers)
+    : m_num_consumers(num_consumers)
+  {
+    m_capacity = 1;
+    while (m_capacity < capacity) {
+      m_capacity <<= 1;
+    }
+    m_mask = m_capacity - 1;
+    m_entries.reset(new T[m_capacity]);
+    m_stamps.reset(new std::atomic<uint64_t>[m_capacity]); // NOLINT(build/unsigned)
+    m_cursors.reset(new Cursor[m_num_consumers]);
+  }
+
+  SpmcRing(const SpmcRing&) = delete;            ///< SpmcRing is not copy-constructible
+  SpmcRing& operator=(const SpmcRing&) = delete; ///< SpmcRing is not copy-assignable
+  SpmcRing(SpmcRing&&) = delete;                 ///< SpmcRing is not move-constructible
+  SpmcRing& operator=(SpmcRing&&) = delete;      ///< SpmcRing is not move-assignable
+
+  std::size_t capacity() const { return m_capacity; }
+  std::size_t num_consumers() const { return m_num_consumers; }
+
+  //! Producer only. Returns false when the slowest consumer is a full ring behind.
+  bool try_write(const T& entry, uint64_t stamp) // NOLINT(build/unsigned)
+  {
+    auto head = m_head.load(std::memory_order_relaxed);
+    if (head - m_slowest_cache >= m_capacity) {
+      m_slowest_cache = min_position();
+      if (head - m_slowest_cache >= m_capacity) {
+        return false;
+      }
+    }
+    m_entries[head & m_mask] = entry;
+    m_stamps[head & m_mask].store(stamp, std::memory_order_relaxed);
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  //! Consumer only. Copies the next entry of the consumer, false when it has read everything.
+  //! The entry stays pending until the consumer calls advance().
+  bool try_read(std::size_t consumer, T& entry) const
+  {
+    auto position = m_cursors[consumer].position.load(std::memory_order_relaxed);
+    if (position == m_head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    entry = m_entries[position & m_mask];
+    return true;
+  }
+
+  //! Consumer only. Copies the entry offset places after the next one, false when it is not written yet
+  bool try_peek(std::size_t consumer, std::size_t offset, T& entry) const
+  {
+    auto position = m_cursors[consumer].position.load(std::memory_order_relaxed) + offset;
+    if (position >= m_head.load(std::memory_order_acquire)) {
+      return false;
+    }
+    entry = m_entries[position & m_mask];
+    return true;
+  }
+
+  //! Consumer only. Done with the next count entries
+  void advance(std::size_t consumer, std::size_t count = 1)
+  {
+    auto& position = m_cursors[consumer].position;
+    position.store(position.load(std::memory_order_relaxed) + count, std::memory_order_release);
+  }
+
+  bool empty(std::size_t consumer) const
+  {
+    return m_cursors[consumer].position.load(std::memory_order_acquire) == m_head.load(std::memory_order_acquire);
+  }
+
+  //! The consumer that is furthest behind
+  std::size_t slowest_consumer() const
+  {
+    std::size_t slowest = 0;
+    auto head = m_head.load(std::memory_order_acquire);
+    uint64_t lag = 0; // NOLINT(build/unsigned)
+    for (std::size_t i = 0; i < m_num_consumers; ++i) {
+      auto consumer_lag = head - m_cursors[i].position.load(std::memory_order_acquire);
+      if (consumer_lag > lag) {
+        lag = consumer_lag;
+        slowest = i;
+      }
+    }
+    return slowest;
+  }
+
+  //! Any thread. Stamp of the oldest entry that some consumer is not done with, s_no_stamp when there is none.
+  //! While the consumers move on the stamp may be older than the true oldest, never newer.
+  uint64_t oldest_pending_stamp() const // NOLINT(build/unsigned)
+  {
+    // The cursors first, so that they are never ahead of the head
+    auto position = min_position();
+    while (true) {
+      auto head = m_head.load(std::memory_order_acquire);
+      if (position == head) {
+        return s_no_stamp;
+      }
+      // Acquire keeps the stamp read before the cursors are read again
+      auto stamp = m_stamps[position & m_mask].load(std::memory_order_acquire);
+      // The slot is only rewritten once every consumer is past it: the stamp belongs to the entry at
+      // position if the slowest cursor is still there
+      auto current = min_position();
+      if (current == position) {
+        return stamp;
+      }
+      position = current;
+    }
+  }
+
+private:
+  // Smallest cursor, read in one pass. Cursors only move forward, so no consumer is behind it.
+  uint64_t min_position() const // NOLINT(build/unsigned)
+  {
+    auto position = m_cursors[0].position.load(std::memory_order_acquire);
+    for (std::size_t i = 1; i < m_num_consumers; ++i) {
+      position = std::min(position, m_cursors[i].position.load(std::memory_order_acquire));
+    }
+    return position;
+  }
+
+  struct alignas(64) Cursor
+  {
+    std::atomic<uint64_t> position{ 0 }; // NOLINT(build/unsigned)
+  };
+
+  std::size_t m_capacity;
+  std::size_t m_mask;
+  std::size_t m_num_consumers;
+  std::unique_ptr<T[]> m_entries;
+  std::unique_ptr<std::atomic<uint64_t>[]> m_stamps; // NOLINT(build/unsigned)
+  std::unique_ptr<Cursor[]> m_cursors;
+
+  alignas(64) std::atomic<uint64_t> m_head{ 0 }; // NOLINT(build/unsigned)
+  uint64_t m_slowest_cache = 0;                  // Producer side copy of the slowest cursor // NOLINT(build/unsigned)
+};
+
+} // namespace readout
+} // namespace dunedaq
+
+#endif // READOUT_INCLUDE_READOUT_UTILS_SPMCRING_HPP_
@@ -13,6 +13,7 @@
 #include "trigger/TPSet.hpp"
 #include "triggeralgs/TriggerPrimitive.hpp"
 
+#include <mutex>
 #include <queue>
 #include <utility>
 #include <vector>
@@ -20,6 +21,9 @@
 namespace dunedaq {
 namespace readout {
 
+// TPs may be added and sent from several threads, e.g. by collection and induction hit finding.
+// The buffer is only locked to take a TPSet out of it. It is pushed after the lock is released,
+// so a sink that blocks does not stall the hit finding of the other plane.
 class TPHandler
 {
 public:
@@ -38,6 +42,7 @@ public:
   bool add_tp(triggeralgs::TriggerPrimitive trigprim, uint64_t currentTime) // NOLINT(build/unsigned)
   {
     if (trigprim.time_start + m_tp_timeout > currentTime) {
+      std::lock_guard<std::mutex> lock(m_buffer_mutex);
       m_tp_buffer.push(trigprim);
       return true;
     } else {
@@ -47,8 +52,17 @@ public:
 
   void try_sending_tpsets(uint64_t currentTime) // NOLINT(build/unsigned)
   {
-    if (!m_tp_buffer.empty() && m_tp_buffer.top().time_start + m_tpset_window_size + m_tp_timeout < currentTime) {
-      trigger::TPSet tpset;
+    // One thread sends at a time, so that the TPSets go out in order. The others leave it to that one.
+    std::unique_lock<std::mutex> send_lock(m_send_mutex, std::try_to_lock);
+    if (!send_lock.owns_lock()) {
+      return;
+    }
+    trigger::TPSet tpset;
+    {
+      std::lock_guard<std::mutex> lock(m_buffer_mutex);
+      if (m_tp_buffer.empty() || m_tp_buffer.top().time_start + m_tpset_window_size + m_tp_timeout >= currentTime) {
+        return;
+      }
       tpset.start_time = (m_tp_buffer.top().time_start / m_tpset_window_size) * m_tpset_window_size;
       tpset.end_time = tpset.start_time + m_tpset_window_size;
       tpset.seqno = m_next_tpset_seqno++; // NOLINT(runtime/increment_decrement)
@@ -56,30 +70,33 @@ public:
       tpset.origin = m_geoid;
 
       while (!m_tp_buffer.empty() && m_tp_buffer.top().time_start < tpset.end_time) {
-        triggeralgs::TriggerPrimitive tp = m_tp_buffer.top();
-        types::SW_WIB_TRIGGERPRIMITIVE_STRUCT* tp_readout_type =
-          reinterpret_cast<types::SW_WIB_TRIGGERPRIMITIVE_STRUCT*>(&tp); // NOLINT
-        try {
-          m_tp_sink.push(*tp_readout_type);
-          m_sent_tps++;
-        } catch (const dunedaq::appfwk::QueueTimeoutExpired& excpt) {
-          ers::error(CannotWriteToQueue(ERS_HERE, m_geoid, "m_tp_sink"));
-        }
-        tpset.objects.emplace_back(std::move(tp));
+        tpset.objects.emplace_back(m_tp_buffer.top());
         m_tp_buffer.pop();
       }
+    }
 
+    for (auto& tp : tpset.objects) {
+      types::SW_WIB_TRIGGERPRIMITIVE_STRUCT* tp_readout_type =
+        reinterpret_cast<types::SW_WIB_TRIGGERPRIMITIVE_STRUCT*>(&tp); // NOLINT
       try {
-        m_tpset_sink.push(std::move(tpset));
-        m_sent_tpsets++;
+        m_tp_sink.push(*tp_readout_type);
+        m_sent_tps++;
       } catch (const dunedaq::appfwk::QueueTimeoutExpired& excpt) {
-        ers::error(CannotWriteToQueue(ERS_HERE, m_geoid, "m_tpset_sink"));
+        ers::error(CannotWriteToQueue(ERS_HERE, m_geoid, "m_tp_sink"));
       }
     }
+
+    try {
+      m_tpset_sink.push(std::move(tpset));
+      m_sent_tpsets++;
+    } catch (const dunedaq::appfwk::QueueTimeoutExpired& excpt) {
+      ers::error(CannotWriteToQueue(ERS_HERE, m_geoid, "m_tpset_sink"));
+    }
   }
 
   void reset()
   {
+    std::lock_guard<std::mutex> lock(m_buffer_mutex);
     while (!m_tp_buffer.empty()) {
       m_tp_buffer.pop();
     }
@@ -113,6 +130,8 @@ private:
   };
   std::priority_queue<triggeralgs::TriggerPrimitive, std::vector<triggeralgs::TriggerPrimitive>, TPComparator>
     m_tp_buffer;
+  std::mutex m_buffer_mutex;
+  std::mutex m_send_mutex;
 };
 
 } // namespace readout
@@ -0,0 +1,98 @@
+/**
+ * @file ThreadAffinity.hpp CPU placement of the readout threads
+ * CPU sets are given as cpulist strings, as in /sys and taskset ("0-3,8,10-11").
+ * A NUMA node is turned into the CPUs of that node, so that the first touch of the
+ * memory a thread allocates lands on the node.
+ *
+ * This is part of the DUNE DAQ , copyright 2021.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef READOUT_INCLUDE_READOUT_UTILS_THREADAFFINITY_HPP_
+#define READOUT_INCLUDE_READOUT_UTILS_THREADAFFINITY_HPP_
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace dunedaq {
+namespace readout {
+
+//! CPUs of a cpulist string, empty for an empty or malformed string
+inline std::vector<int>
+parse_cpu_list(const std::string& cpu_list)
+{
+  std::vector<int> cpus;
+  std::stringstream ranges(cpu_list);
+  std::string range;
+  try {
+    while (std::getline(ranges, range, ',')) {
+      if (range.empty()) {
+        continue;
+      }
+      auto dash = range.find('-');
+      int first = std::stoi(range.substr(0, dash));
+      int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+      for (int cpu = first; cpu <= last; ++cpu) {
+        cpus.push_back(cpu);
+      }
+    }
+  } catch (const std::exception&) {
+    cpus.clear();
+  }
+  return cpus;
+}
+
+//! CPUs of a NUMA node, empty when the node does not exist
+inline std::vector<int>
+numa_node_cpus(int numa_node)
+{
+  std::ifstream cpulist_file("/sys/devices/system/node/node" + std::to_string(numa_node) + "/cpulist");
+  std::string cpu_list;
+  std::getline(cpulist_file, cpu_list);
+  return parse_cpu_list(cpu_list);
+}
+
+//! CPUs for a thread role: its own cpulist, else the default cpulist, else the CPUs of the NUMA node.
+//! Empty means no placement.
+inline std::vector<int>
+resolve_cpus(const std::string& role_cpus, const std::string& default_cpus, int numa_node)
+{
+  if (!role_cpus.empty()) {
+    return parse_cpu_list(role_cpus);
+  }
+  if (!default_cpus.empty()) {
+    return parse_cpu_list(default_cpus);
+  }
+  if (numa_node >= 0) {
+    return numa_node_cpus(numa_node);
+  }
+  return {};
+}
+
+//! Returns false when the affinity could not be set, nothing is done for an empty CPU set
+inline bool
+set_thread_affinity(pthread_t handle, const std::vector<int>& cpus)
+{
+  if (cpus.empty()) {
+    return true;
+  }
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  for (auto cpu : cpus) {
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+      return false;
+    }
+    CPU_SET(cpu, &cpu_set);
+  }
+  return pthread_setaffinity_np(handle, sizeof(cpu_set), &cpu_set) == 0;
+}
+
+} // namespace readout
+} // namespace dunedaq
+
+#endif // READOUT_INCLUDE_READOUT_UTILS_THREADAFFINITY_HPP_
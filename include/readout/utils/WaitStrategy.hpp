@@ -0,0 +1,163 @@
+/**
+ * @file WaitStrategy.hpp How an idle worker waits for new work
+ * sleep: sleep a fixed time between polls
+ * spin: poll without pause, lowest latency, burns a core
+ * yield: spin for a while, then yield the core between polls
+ * park: spin for a while, then block until a producer calls notify(), at most s_park_timeout
+ *
+ * This is part of the DUNE DAQ , copyright 2021.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef READOUT_INCLUDE_READOUT_UTILS_WAITSTRATEGY_HPP_
+#define READOUT_INCLUDE_READOUT_UTILS_WAITSTRATEGY_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace dunedaq {
+namespace readout {
+
+class WaitStrategy
+{
+public:
+  enum class Mode
+  {
+    kSleep,
+    kSpin,
+    kSpinYield,
+    kPark
+  };
+
+  static constexpr int s_spin_iterations = 1000;
+  static constexpr std::chrono::milliseconds s_park_timeout{ 10 };
+
+  explicit WaitStrategy(std::chrono::microseconds sleep_time)
+    : m_sleep_time(sleep_time)
+  {}
+
+  WaitStrategy(const WaitStrategy&) = delete;            ///< WaitStrategy is not copy-constructible
+  WaitStrategy& operator=(const WaitStrategy&) = delete; ///< WaitStrategy is not copy-assignable
+  WaitStrategy(WaitStrategy&&) = delete;                 ///< WaitStrategy is not move-constructible
+  WaitStrategy& operator=(WaitStrategy&&) = delete;      ///< WaitStrategy is not move-assignable
+
+  //! Returns false for an unknown name, the mode is left unchanged then
+  bool set_mode(const std::string& name)
+  {
+    if (name == "sleep") {
+      m_mode = Mode::kSleep;
+    } else if (name == "spin") {
+      m_mode = Mode::kSpin;
+    } else if (name == "yield") {
+      m_mode = Mode::kSpinYield;
+    } else if (name == "park") {
+      m_mode = Mode::kPark;
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  Mode get_mode() const { return m_mode; }
+
+  //! Called by the worker when it ran out of work. Returns once ready() holds, or after a timed
+  //! sleep in sleep and park mode. The caller checks for work again either way.
+  template<typename Ready>
+  void wait(Ready&& ready)
+  {
+    switch (m_mode) {
+      case Mode::kSleep:
+        if (!ready()) {
+          std::this_thread::sleep_for(m_sleep_time);
+        }
+        return;
+      case Mode::kSpin:
+        while (!ready()) {
+          cpu_relax();
+        }
+        return;
+      case Mode::kSpinYield:
+        if (!spin(ready)) {
+          while (!ready()) {
+            std::this_thread::yield();
+          }
+        }
+        return;
+      case Mode::kPark:
+        if (!spin(ready)) {
+          park(ready);
+        }
+        return;
+    }
+  }
+
+  //! Called by producers after publishing work, only takes the lock when a worker is parked
+  void notify()
+  {
+    if (m_mode != Mode::kPark) {
+      return;
+    }
+    // Pairs with the increment in park(): either the worker sees the work, or we see the worker
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_parked.load(std::memory_order_relaxed) > 0) {
+      std::lock_guard<std::mutex> lock(m_park_lock);
+      m_park_cv.notify_all();
+    }
+  }
+
+  //! Wake up parked workers regardless of their work, e.g. at stop
+  void notify_all()
+  {
+    std::lock_guard<std::mutex> lock(m_park_lock);
+    m_park_cv.notify_all();
+  }
+
+private:
+  static void cpu_relax()
+  {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+  }
+
+  template<typename Ready>
+  static bool spin(Ready& ready)
+  {
+    for (int i = 0; i < s_spin_iterations; ++i) {
+      if (ready()) {
+        return true;
+      }
+      cpu_relax();
+    }
+    return false;
+  }
+
+  template<typename Ready>
+  void park(Ready& ready)
+  {
+    m_parked.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    {
+      std::unique_lock<std::mutex> lock(m_park_lock);
+      if (!ready()) {
+        m_park_cv.wait_for(lock, s_park_timeout);
+      }
+    }
+    m_parked.fetch_sub(1);
+  }
+
+  Mode m_mode = Mode::kSleep;
+  std::chrono::microseconds m_sleep_time;
+  std::atomic<int> m_parked{ 0 };
+  std::mutex m_park_lock;
+  std::condition_variable m_park_cv;
+};
+
+} // namespace readout
+} // namespace dunedaq
+
+#endif // READOUT_INCLUDE_READOUT_UTILS_WAITSTRATEGY_HPP_
@@ -0,0 +1,228 @@
+/**
+ * @file WorkStealingExecutor.hpp Process-wide thread pool with work stealing
+ * Work is submitted through strands. A strand runs on one pool thread at a time, so the work of
+ * a strand is done in order, while the strands of different links are spread over the pool.
+ * Every pool thread has its own queue of strands and steals from the others when it runs dry.
+ *
+ * This is part of the DUNE DAQ , copyright 2021.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#ifndef READOUT_INCLUDE_READOUT_UTILS_WORKSTEALINGEXECUTOR_HPP_
+#define READOUT_INCLUDE_READOUT_UTILS_WORKSTEALINGEXECUTOR_HPP_
+
+#include "readout/utils/ReusableThread.hpp"
+#include "readout/utils/WaitStrategy.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace dunedaq {
+namespace readout {
+
+class WorkStealingExecutor
+{
+public:
+  class Strand;
+
+  static constexpr std::chrono::microseconds s_idle_sleep{ 50 };
+
+  //! The pool shared by all links of the process
+  static WorkStealingExecutor& instance()
+  {
+    static WorkStealingExecutor s_executor;
+    return s_executor;
+  }
+
+  WorkStealingExecutor() = default;
+
+  // The workers are done before the queues and the wait strategy go away
+  ~WorkStealingExecutor()
+  {
+    m_quit.store(true);
+    while (!all_ready(m_workers)) {
+      m_wait.notify_all();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  WorkStealingExecutor(const WorkStealingExecutor&) = delete;            ///< not copy-constructible
+  WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete; ///< not copy-assignable
+  WorkStealingExecutor(WorkStealingExecutor&&) = delete;                 ///< not move-constructible
+  WorkStealingExecutor& operator=(WorkStealingExecutor&&) = delete;      ///< not move-assignable
+
+  //! Starts the pool threads on the first call, later calls only check the size.
+  //! Returns false when the pool runs with another number of threads, or its threads could not be placed.
+  bool start(std::size_t num_threads, const std::vector<int>& cpus)
+  {
+    std::lock_guard<std::mutex> lock(m_start_lock);
+    if (!m_workers.empty()) {
+      return m_workers.size() == num_threads;
+    }
+    bool placed = true;
+    m_queues.reserve(num_threads);
+    for (std::size_t i = 0; i < num_threads; ++i) {
+      m_queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    m_wait.set_mode("park");
+    for (std::size_t i = 0; i < num_threads; ++i) {
+      m_workers.push_back(std::make_unique<ReusableThread>(0));
+      m_workers.back()->set_name("tpg-pool", i);
+      placed = m_workers.back()->set_affinity(cpus) && placed;
+      m_workers.back()->set_work(&WorkStealingExecutor::run_worker, this, i);
+    }
+    return placed;
+  }
+
+  std::size_t num_threads() const { return m_queues.size(); }
+
+  //! A strand that calls work until it returns false, i.e. until there is nothing left to do.
+  //! The pool has to be started.
+  std::unique_ptr<Strand> make_strand(std::function<bool()> work)
+  {
+    auto home = m_next_home.fetch_add(1) % m_queues.size();
+    return std::unique_ptr<Strand>(new Strand(*this, home, std::move(work)));
+  }
+
+  class Strand
+  {
+  public:
+    Strand(const Strand&) = delete;            ///< Strand is not copy-constructible
+    Strand& operator=(const Strand&) = delete; ///< Strand is not copy-assignable
+    Strand(Strand&&) = delete;                 ///< Strand is not move-constructible
+    Strand& operator=(Strand&&) = delete;      ///< Strand is not move-assignable
+
+    //! Called by producers after publishing work. The strand is queued unless it is already.
+    void notify()
+    {
+      m_pending.store(true);
+      if (!m_scheduled.exchange(true)) {
+        m_executor.push(this, m_home);
+      }
+    }
+
+    //! Neither queued nor running. A strand may only be destroyed when it is idle and is not notified anymore.
+    bool idle() const
+    {
+      // A pool thread holds the lock until it is done with the strand
+      std::lock_guard<std::mutex> lock(m_run_lock);
+      return !m_scheduled.load();
+    }
+
+  private:
+    friend class WorkStealingExecutor;
+
+    Strand(WorkStealingExecutor& executor, std::size_t home, std::function<bool()> work)
+      : m_executor(executor)
+      , m_home(home)
+      , m_work(std::move(work))
+    {}
+
+    // Only one pool thread gets here at a time, the strand is scheduled until it ran out of work
+    void run(std::size_t worker)
+    {
+      std::lock_guard<std::mutex> lock(m_run_lock);
+      m_pending.store(false);
+      if (m_work()) {
+        // More work, back to the end of the queue so that the other strands get their turn
+        m_executor.push(this, worker);
+        return;
+      }
+      m_scheduled.store(false);
+      // A notify that came after the work ran out, but saw the strand still scheduled
+      if (m_pending.load() && !m_scheduled.exchange(true)) {
+        m_executor.push(this, worker);
+      }
+    }
+
+    WorkStealingExecutor& m_executor;
+    std::size_t m_home;
+    std::function<bool()> m_work;
+    std::atomic<bool> m_scheduled{ false };
+    std::atomic<bool> m_pending{ false };
+    mutable std::mutex m_run_lock;
+  };
+
+private:
+  struct WorkerQueue
+  {
+    std::mutex lock;
+    std::deque<Strand*> strands;
+  };
+
+  template<class Workers>
+  static bool all_ready(const Workers& workers)
+  {
+    for (auto& worker : workers) {
+      if (!worker->get_readiness()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void push(Strand* strand, std::size_t worker)
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_queues[worker]->lock);
+      m_queues[worker]->strands.push_back(strand);
+      m_queued.fetch_add(1);
+    }
+    m_wait.notify();
+  }
+
+  // The owner works from the front of its queue, thieves take from the back
+  Strand* pop(std::size_t worker)
+  {
+    for (std::size_t i = 0; i < m_queues.size(); ++i) {
+      auto& queue = *m_queues[(worker + i) % m_queues.size()];
+      std::lock_guard<std::mutex> lock(queue.lock);
+      if (queue.strands.empty()) {
+        continue;
+      }
+      Strand* strand;
+      if (i == 0) {
+        strand = queue.strands.front();
+        queue.strands.pop_front();
+      } else {
+        strand = queue.strands.back();
+        queue.strands.pop_back();
+      }
+      m_queued.fetch_sub(1);
+      return strand;
+    }
+    return nullptr;
+  }
+
+  void run_worker(std::size_t worker)
+  {
+    while (!m_quit.load()) {
+      if (auto* strand = pop(worker)) {
+        strand->run(worker);
+      } else {
+        m_wait.wait([&]() { return m_queued.load() > 0 || m_quit.load(); });
+      }
+    }
+  }
+
+  std::mutex m_start_lock;
+  std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+  std::vector<std::unique_ptr<ReusableThread>> m_workers;
+  std::atomic<std::size_t> m_queued{ 0 };
+  std::atomic<std::size_t> m_next_home{ 0 };
+  std::atomic<bool> m_quit{ false };
+  WaitStrategy m_wait{ s_idle_sleep };
+};
+
+} // namespace readout
+} // namespace dunedaq
+
+#endif // READOUT_INCLUDE_READOUT_UTILS_WORKSTEALINGEXECUTOR_HPP_
@@ -42,6 +42,9 @@ DataLinkHandler::init(const data_t& args)
 
   TLOG_DEBUG(TLVL_ENTER_EXIT_METHODS) << get_name() << ": Entering init() method";
   m_readout_impl = createReadout(args, m_run_marker);
+  if (m_readout_impl == nullptr) {
+    m_readout_impl = createReadoutGroup(args, m_run_marker);
+  }
   if (m_readout_impl == nullptr) {
     TLOG() << get_name() << "Initialize readout implementation FAILED! "
            << "Failed to find specialization for given queue setup!";
@@ -19,6 +19,7 @@
 
 #include "readout/ReadoutIssues.hpp"
 #include "readout/concepts/ReadoutConcept.hpp"
+#include "readout/models/ReadoutGroupModel.hpp"
 #include "readout/models/ReadoutModel.hpp"
 
 #include "daphne/DAPHNEFrameProcessor.hpp"
@@ -40,10 +41,12 @@
 #include "readout/models/FixedRateQueueModel.hpp"
 
 #include "readout/models/EmptyFragmentRequestHandlerModel.hpp"
+#include "readout/models/VariableSizeQueueModel.hpp"
 
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
 using dunedaq::readout::logging::TLVL_WORK_STEPS;
 
@@ -135,8 +138,8 @@ createReadout(const nlohmann::json& args, std::atomic<bool>& run_marker)
         auto readout_model = std::make_unique<
           ReadoutModel<types::RAW_WIB_TRIGGERPRIMITIVE_STRUCT,
                        EmptyFragmentRequestHandlerModel<types::RAW_WIB_TRIGGERPRIMITIVE_STRUCT,
-                                                        BinarySearchQueueModel<types::RAW_WIB_TRIGGERPRIMITIVE_STRUCT>>,
-                       BinarySearchQueueModel<types::RAW_WIB_TRIGGERPRIMITIVE_STRUCT>,
+                                                        VariableSizeQueueModel<types::RAW_WIB_TRIGGERPRIMITIVE_STRUCT>>,
+                       VariableSizeQueueModel<types::RAW_WIB_TRIGGERPRIMITIVE_STRUCT>,
                        RAWWIBTriggerPrimitiveProcessor>>(run_marker);
         readout_model->init(args);
         return std::move(readout_model);
@@ -145,10 +148,11 @@ createReadout(const nlohmann::json& args, std::atomic<bool>& run_marker)
       // IF ND LAr PACMAN
       if (inst.find("pacman") != std::string::npos) {
         TLOG_DEBUG(TLVL_WORK_STEPS) << "Creating readout for a pacman";
-        auto readout_model = std::make_unique<ReadoutModel<types::PACMAN_MESSAGE_STRUCT,
-                                                           PACMANListRequestHandler,
-                                                           SkipListLatencyBufferModel<types::PACMAN_MESSAGE_STRUCT>,
-                                                           PACMANFrameProcessor>>(run_marker);
+        auto readout_model = std::make_unique<
+          ReadoutModel<types::PACMAN_MESSAGE_STRUCT,
+                       PACMANListRequestHandler,
+                       VariableSizeQueueModel<types::PACMAN_MESSAGE_STRUCT>,
+                       PACMANFrameProcessor>>(run_marker);
         readout_model->init(args);
         return readout_model;
       }
@@ -163,6 +167,44 @@ createReadout(const nlohmann::json& args, std::atomic<bool>& run_marker)
   return nullptr;
 }
 
+// Grouped mode: the queues of link N are named link<N>.raw_input, link<N>.timesync, link<N>.data_requests_<i>, ...
+// Each link is created from its own queues with the prefix stripped, then the links are driven by one group.
+std::unique_ptr<ReadoutConcept>
+createReadoutGroup(const nlohmann::json& args, std::atomic<bool>& run_marker)
+{
+  auto queues = args.get<appfwk::app::ModInit>().qinfos;
+  std::vector<std::unique_ptr<ReadoutConcept>> links;
+  while (true) {
+    auto prefix = "link" + std::to_string(links.size()) + ".";
+    appfwk::app::ModInit link_init;
+    for (const auto& qi : queues) {
+      if (qi.name.rfind(prefix, 0) == 0) {
+        auto link_qi = qi;
+        link_qi.name = qi.name.substr(prefix.size());
+        link_init.qinfos.push_back(link_qi);
+      }
+    }
+    if (link_init.qinfos.empty()) {
+      break;
+    }
+    nlohmann::json link_args;
+    appfwk::app::to_json(link_args, link_init);
+    auto link = createReadout(link_args, run_marker);
+    if (link == nullptr) {
+      return nullptr;
+    }
+    links.push_back(std::move(link));
+  }
+  if (links.empty()) {
+    return nullptr;
+  }
+
+  TLOG_DEBUG(TLVL_WORK_STEPS) << "Creating readout group of " << links.size() << " links";
+  auto readout_group = std::make_unique<ReadoutGroupModel>(run_marker, std::move(links));
+  readout_group->init(args);
+  return readout_group;
+}
+
 } // namespace readout
 } // namespace dunedaq
 
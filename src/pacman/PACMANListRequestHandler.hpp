@@ -10,7 +10,7 @@
 
 #include "readout/ReadoutIssues.hpp"
 #include "readout/models/DefaultRequestHandlerModel.hpp"
-#include "readout/models/SkipListLatencyBufferModel.hpp"
+#include "readout/models/VariableSizeQueueModel.hpp"
 
 #include "detdataformats/pacman/PACMANFrame.hpp"
 #include "logging/Logging.hpp"
@@ -35,19 +35,17 @@ namespace readout {
 
 class PACMANListRequestHandler
   : public DefaultRequestHandlerModel<types::PACMAN_MESSAGE_STRUCT,
-                                      SkipListLatencyBufferModel<types::PACMAN_MESSAGE_STRUCT>>
+                                      VariableSizeQueueModel<types::PACMAN_MESSAGE_STRUCT>>
 {
 public:
   using inherited =
-    DefaultRequestHandlerModel<types::PACMAN_MESSAGE_STRUCT, SkipListLatencyBufferModel<types::PACMAN_MESSAGE_STRUCT>>;
-  using SkipListAcc = typename folly::ConcurrentSkipList<types::PACMAN_MESSAGE_STRUCT>::Accessor;
-  using SkipListSkip = typename folly::ConcurrentSkipList<types::PACMAN_MESSAGE_STRUCT>::Skipper;
+    DefaultRequestHandlerModel<types::PACMAN_MESSAGE_STRUCT, VariableSizeQueueModel<types::PACMAN_MESSAGE_STRUCT>>;
 
-  PACMANListRequestHandler(std::unique_ptr<SkipListLatencyBufferModel<types::PACMAN_MESSAGE_STRUCT>>& latency_buffer,
+  PACMANListRequestHandler(std::unique_ptr<VariableSizeQueueModel<types::PACMAN_MESSAGE_STRUCT>>& latency_buffer,
                            std::unique_ptr<FrameErrorRegistry>& error_registry)
     : DefaultRequestHandlerModel<types::PACMAN_MESSAGE_STRUCT,
-                                 SkipListLatencyBufferModel<types::PACMAN_MESSAGE_STRUCT>>(latency_buffer,
-                                                                                           error_registry)
+                                 VariableSizeQueueModel<types::PACMAN_MESSAGE_STRUCT>>(latency_buffer,
+                                                                                       error_registry)
   {
     TLOG_DEBUG(TLVL_WORK_STEPS) << "PACMANistRequestHandler created...";
   }
@@ -11,6 +11,7 @@
 #include "appfwk/DAQModuleHelper.hpp"
 #include "readout/ReadoutIssues.hpp"
 #include "readout/models/TaskRawDataProcessorModel.hpp"
+#include "readout/models/VariableSizeQueueModel.hpp"
 
 #include "readout/RawWIBTp.hpp"
 #include "logging/Logging.hpp"
@@ -21,6 +22,8 @@
 #include "triggeralgs/TriggerPrimitive.hpp"
 
 #include <atomic>
+#include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <memory>
 #include <string>
@@ -30,6 +33,47 @@ using dunedaq::readout::logging::TLVL_BOOKKEEPING;
 namespace dunedaq {
   namespace readout {
 
+    /**
+     * Raw WIB TPs are stored in the byte ring as a non-owning element followed by the RawWIBTp frame itself,
+     * so the LB holds no heap allocations.
+     * */
+    template<>
+    struct VariableSizeElementTraits<types::RAW_WIB_TRIGGERPRIMITIVE_STRUCT>
+    {
+      using element_t = types::RAW_WIB_TRIGGERPRIMITIVE_STRUCT;
+      using frame_t = element_t::FrameType;
+
+      // Room for a frame with a few hits, most frames are smaller
+      static constexpr std::size_t default_element_bytes =
+        sizeof(element_t) + sizeof(frame_t) + 3 * sizeof(detdataformats::TpData);
+
+      static std::size_t stored_size(element_t& element) { return sizeof(element_t) + element.rwtp->get_frame_size(); }
+
+      static void store(element_t& element, char* dest)
+      {
+        auto frame = reinterpret_cast<frame_t*>(dest + sizeof(element_t)); // NOLINT
+        std::memcpy(static_cast<void*>(frame), static_cast<void*>(element.rwtp.get()), element.rwtp->get_frame_size());
+        new (dest) element_t;
+        view(dest)->rwtp.reset(frame);
+      }
+
+      static element_t* view(char* stored) { return reinterpret_cast<element_t*>(stored); } // NOLINT
+
+      static void load(char* stored, std::size_t size, element_t& element)
+      {
+        auto frame_size = size - sizeof(element_t);
+        element.rwtp.reset(static_cast<frame_t*>(malloc(frame_size)));
+        std::memcpy(static_cast<void*>(element.rwtp.get()), stored + sizeof(element_t), frame_size);
+      }
+
+      static void release(char* stored)
+      {
+        // The frame lives in the ring, it must not be deleted
+        view(stored)->rwtp.release();
+        view(stored)->~element_t();
+      }
+    };
+
     class RAWWIBTriggerPrimitiveProcessor : public TaskRawDataProcessorModel<types::RAW_WIB_TRIGGERPRIMITIVE_STRUCT>
     {
 
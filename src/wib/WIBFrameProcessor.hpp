@@ -17,8 +17,11 @@
 #include "readout/FrameErrorRegistry.hpp"
 #include "readout/models/IterableQueueModel.hpp"
 #include "readout/models/TaskRawDataProcessorModel.hpp"
+#include "readout/utils/FramePipeline.hpp"
 #include "readout/utils/ReusableThread.hpp"
 #include "readout/utils/TPHandler.hpp"
+#include "readout/utils/WaitStrategy.hpp"
+#include "readout/utils/WorkStealingExecutor.hpp"
 
 #include "detdataformats/wib/WIBFrame.hpp"
 #include "trigger/TPSet.hpp"
@@ -30,8 +33,10 @@
 #include "tpg/ProcessingInfo.hpp"
 #include "tpg/TPGConstants.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <bitset>
+#include <chrono>
 #include <functional>
 #include <future>
 #include <memory>
@@ -65,13 +70,7 @@ public:
     , m_coll_taps_p(nullptr)
     , m_ind_primfind_dest(nullptr)
     , m_ind_taps_p(nullptr)
-  {
-    // Setup pre-processing pipeline
-    TaskRawDataProcessorModel<types::WIB_SUPERCHUNK_STRUCT>::add_preprocess_task(
-      std::bind(&WIBFrameProcessor::timestamp_check, this, std::placeholders::_1));
-    TaskRawDataProcessorModel<types::WIB_SUPERCHUNK_STRUCT>::add_preprocess_task(
-      std::bind(&WIBFrameProcessor::frame_error_check, this, std::placeholders::_1));
-  }
+  {}
 
   ~WIBFrameProcessor()
   {
@@ -139,11 +138,11 @@ public:
         0,
         0);
 
-      m_ind_tpg_pi = std::make_unique<swtpg::ProcessingInfo<swtpg::REGISTERS_PER_FRAME>>(
+      m_ind_tpg_pi = std::make_unique<swtpg::ProcessingInfo<swtpg::INDUCTION_REGISTERS_PER_FRAME>>(
         nullptr,
         swtpg::FRAMES_PER_MSG,
         0,
-        10,
+        swtpg::INDUCTION_REGISTERS_PER_FRAME,
         m_ind_primfind_dest,
         m_ind_taps_p,
         (uint8_t)m_ind_taps.size(), // NOLINT(build/unsigned)
@@ -151,6 +150,7 @@ public:
         m_ind_threshold,
         0,
         0);
+      m_ind_tpg_pi->hold_ticks = m_ind_hold_ticks;
     }
 
     // Reset timestamp check
@@ -162,20 +162,47 @@ public:
 
     // Reset stats
     m_first_coll = true;
+    m_first_ind = true;
     m_t0 = std::chrono::high_resolution_clock::now();
     m_new_hits = 0;
     m_new_tps = 0;
     m_coll_hits_count.exchange(0);
+    m_indu_hits_count.exchange(0);
+    m_coll_busy_ns = 0;
+    m_coll_bytes = 0;
+    m_ind_busy_ns = 0;
+    m_ind_bytes = 0;
+    m_ind_items_dropped = 0;
+    m_coll_done_ts = 0;
+    m_ind_done_ts = 0;
     m_frame_error_count = 0;
     m_frames_processed = 0;
 
     inherited::start(args);
+
+    // The induction hit finding follows the collection one, it stops once the run is over and its queue is empty
+    if (m_sw_tpg_enabled && m_induction_strand == nullptr) {
+      m_induction_thread.set_work(&WIBFrameProcessor::run_induction_thread, this);
+    }
   }
 
   void stop(const nlohmann::json& args) override
   {
     inherited::stop(args);
     if (m_sw_tpg_enabled) {
+      // The collection hit finding is done, the induction one works off what it queued
+      if (m_induction_strand != nullptr) {
+        m_induction_strand->notify();
+        while (!m_induction_items_to_process->isEmpty() || !m_induction_strand->idle()) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+      } else {
+        m_induction_wait.notify_all();
+        while (!m_induction_thread.get_readiness()) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+      }
+
       // Make temp. buffers reusable on next start.
       if (m_coll_taps_p) {
         delete[] m_coll_taps_p;
@@ -226,15 +253,46 @@ public:
 
       m_tphandler.reset(new TPHandler(*m_tp_sink, *m_tpset_sink, config.tp_timeout, config.tpset_window_size, m_geoid));
 
-      m_induction_items_to_process =
-        std::make_unique<IterableQueueModel<InductionItemToProcess>>(200000, false, 0, true, 64); // 64 byte aligned
+      m_induction_items_to_process = std::make_unique<IterableQueueModel<InductionItemToProcess>>(
+        config.postprocess_queue_sizes, false, 0, true, 64); // 64 byte aligned
 
       // Setup parallel post-processing
-      TaskRawDataProcessorModel<types::WIB_SUPERCHUNK_STRUCT>::add_postprocess_task(
-        std::bind(&WIBFrameProcessor::find_collection_hits, this, std::placeholders::_1));
+      m_coll_window_superchunks =
+        std::min(s_max_window_superchunks, static_cast<size_t>(std::max(1, config.postprocess_span_size)));
+      m_coll_window_registers.reset(new swtpg::MessageRegistersCollection[m_coll_window_superchunks]);
+      // The collection TPG may run on the shared pool, tpg_pool_threads decides
+      TaskRawDataProcessorModel<types::WIB_SUPERCHUNK_STRUCT>::add_postprocess_span_task(
+        std::bind(&WIBFrameProcessor::find_collection_hits, this, std::placeholders::_1, std::placeholders::_2), true);
     }
 
     TaskRawDataProcessorModel<types::WIB_SUPERCHUNK_STRUCT>::conf(cfg);
+
+    // The induction hit finding runs on the shared pool with the collection one, or on a thread of its own
+    if (m_sw_tpg_enabled) {
+      m_induction_wait.set_mode(config.postprocess_wait_strategy);
+      m_induction_strand.reset();
+      if (config.tpg_pool_threads > 0) {
+        m_induction_strand =
+          WorkStealingExecutor::instance().make_strand([this]() { return run_induction_strand(); });
+      } else {
+        auto affinity = cfg["threadaffinityconf"].get<readoutconfig::ThreadAffinityConf>();
+        m_induction_thread.set_name("induction", m_geoid.element_id);
+        if (!m_induction_thread.set_affinity(
+              resolve_cpus(affinity.postprocess_cpus, affinity.cpus, affinity.numa_node))) {
+          ers::warning(ConfigurationError(ERS_HERE, m_geoid, "Could not set the CPU affinity of the induction thread"));
+        }
+      }
+    }
+  }
+
+  // The pre-processing pipeline is fixed, its stages run in one pass over the frames of the superchunk.
+  // Tasks added with add_preprocess_task run after it.
+  void preprocess_item(frameptr fp) final
+  {
+    using preprocess_stages_t =
+      FramePipeline<&WIBFrameProcessor::timestamp_check, &WIBFrameProcessor::frame_error_check>;
+    preprocess_stages_t::run(*this, reinterpret_cast<wibframeptr>(fp), fp->get_num_frames()); // NOLINT
+    inherited::preprocess_item(fp);
   }
 
   void get_info(opmonlib::InfoCollector& ci, int level)
@@ -251,11 +309,18 @@ public:
     auto now = std::chrono::high_resolution_clock::now();
     if (m_sw_tpg_enabled) {
       int new_hits = m_coll_hits_count.exchange(0);
+      int new_ind_hits = m_indu_hits_count.exchange(0);
       int new_tps = m_num_tps_pushed.exchange(0);
       double seconds = std::chrono::duration_cast<std::chrono::microseconds>(now - m_t0).count() / 1000000.;
-      TLOG_DEBUG(TLVL_TAKE_NOTE) << "Hit rate: " << std::to_string(new_hits / seconds / 1000.) << " [kHz]";
-      TLOG_DEBUG(TLVL_TAKE_NOTE) << "Total new hits: " << new_hits << " new pushes: " << new_tps;
+      TLOG_DEBUG(TLVL_TAKE_NOTE) << "Hit rate: " << std::to_string(new_hits / seconds / 1000.) << " [kHz]"
+                                 << " induction: " << std::to_string(new_ind_hits / seconds / 1000.) << " [kHz]";
+      TLOG_DEBUG(TLVL_TAKE_NOTE) << "Total new hits: " << new_hits << " induction: " << new_ind_hits
+                                 << " new pushes: " << new_tps;
       info.rate_tp_hits = new_hits / seconds / 1000.;
+      info.rate_tp_hits_induction = new_ind_hits / seconds / 1000.;
+      info.throughput_tpg_collection = throughput_mbs(m_coll_bytes, m_coll_busy_ns);
+      info.throughput_tpg_induction = throughput_mbs(m_ind_bytes, m_ind_busy_ns);
+      info.num_induction_items_dropped = m_ind_items_dropped.exchange(0);
     }
     m_t0 = now;
 
@@ -278,24 +343,22 @@ protected:
 
   /**
    * Pipeline Stage 1.: Check proper timestamp increments in WIB frame
+   * The check is done on the first frame of the superchunk, the others are only emulated.
    * */
-  void timestamp_check(frameptr fp)
+  void timestamp_check(wibframeptr wf, size_t frame_index)
   {
     // If EMU data, emulate perfectly incrementing timestamp
-    if (inherited::m_emulator_mode) {                           // emulate perfectly incrementing timestamp
-      uint64_t ts_next = m_previous_ts + 300;                   // NOLINT(build/unsigned)
-      auto wf = reinterpret_cast<wibframeptr>(((uint8_t*)fp));  // NOLINT
-      for (unsigned int i = 0; i < fp->get_num_frames(); ++i) { // NOLINT(build/unsigned)
-        auto wfh = const_cast<dunedaq::detdataformats::wib::WIBHeader*>(wf->get_wib_header());
-        wfh->set_timestamp(ts_next);
-        ts_next += 25;
-        wf++;
-      }
+    if (inherited::m_emulator_mode) {
+      uint64_t ts_next = frame_index == 0 ? m_previous_ts + 300 : m_current_ts + 25 * frame_index; // NOLINT
+      auto wfh = const_cast<dunedaq::detdataformats::wib::WIBHeader*>(wf->get_wib_header());
+      wfh->set_timestamp(ts_next);
+    }
+    if (frame_index != 0) {
+      return;
     }
 
     // Acquire timestamp
-    auto wfptr = reinterpret_cast<dunedaq::detdataformats::wib::WIBFrame*>(fp); // NOLINT
-    m_current_ts = wfptr->get_wib_header()->get_timestamp();
+    m_current_ts = wf->get_wib_header()->get_timestamp();
 
     // Check timestamp
     if (m_current_ts - m_previous_ts != 300) {
@@ -323,24 +386,18 @@ protected:
   /**
    * Pipeline Stage 2.: Check WIB headers for error flags
    * */
-  void frame_error_check(frameptr fp)
+  void frame_error_check(wibframeptr wf, size_t /*frame_index*/)
   {
-    if (!fp)
-      return;
-
-    auto wf = reinterpret_cast<wibframeptr>(((uint8_t*)fp)); // NOLINT
-    for (size_t i = 0; i < fp->get_num_frames(); ++i) {
-      if (m_frames_processed % 10000 == 0) {
-        for (int i = 0; i < m_num_frame_error_bits; ++i) {
-          if (m_error_occurrence_counters[i])
-            m_error_occurrence_counters[i]--;
-        }
+    if (m_frames_processed % 10000 == 0) {
+      for (int i = 0; i < m_num_frame_error_bits; ++i) {
+        if (m_error_occurrence_counters[i])
+          m_error_occurrence_counters[i]--;
       }
+    }
 
-      auto wfh = const_cast<dunedaq::detdataformats::wib::WIBHeader*>(wf->get_wib_header());
-      if (wfh->wib_errors) {
-        m_frame_error_count += std::bitset<16>(wfh->wib_errors).count();
-      }
+    auto wfh = wf->get_wib_header();
+    if (wfh->wib_errors) {
+      m_frame_error_count += std::bitset<16>(wfh->wib_errors).count();
 
       m_current_frame_pushed = false;
       for (int j = 0; j < m_num_frame_error_bits; ++j) {
@@ -358,32 +415,41 @@ protected:
           }
         }
       }
-      wf++;
-      m_frames_processed++;
     }
+    m_frames_processed++;
   }
 
   /**
    * Pipeline Stage 3.: Do software TPG
+   * Superchunks that follow each other without a gap are processed as one window of 12 frames each,
+   * so that the pedestal and filter state stays in registers across the window.
    * */
-  void find_collection_hits(constframeptr fp)
+  void find_collection_hits(constframeptr fp, size_t count)
   {
     if (!fp)
       return;
 
+    size_t begin = 0;
+    while (begin < count) {
+      size_t window = 1;
+      auto first_timestamp = fp[begin].get_first_timestamp();
+      while (begin + window < count && window < m_coll_window_superchunks &&
+             fp[begin + window].get_first_timestamp() == first_timestamp + window * s_superchunk_ticks) {
+        ++window;
+      }
+      find_collection_hits_window(fp + begin, window);
+      begin += window;
+    }
+  }
+
+  void find_collection_hits_window(constframeptr fp, size_t window)
+  {
+    auto begin = std::chrono::steady_clock::now();
     auto wfptr = reinterpret_cast<dunedaq::detdataformats::wib::WIBFrame*>((uint8_t*)fp); // NOLINT
     uint64_t timestamp = wfptr->get_wib_header()->get_timestamp();                // NOLINT(build/unsigned)
 
-    swtpg::MessageRegistersCollection collection_registers;
-
-    // InductionItemToProcess* ind_item = &m_dummy_induction_item;
-    InductionItemToProcess ind_item;
-    expand_message_adcs_inplace(fp, &collection_registers, &ind_item.registers);
-    m_induction_items_to_process->write(std::move(ind_item));
-
+    // Set before the first induction item is queued, the induction hit finding reads them
     if (m_first_coll) {
-      m_coll_tpg_pi->setState(collection_registers);
-
       m_fiber_no = wfptr->get_wib_header()->fiber_no;
       m_crate_no = wfptr->get_wib_header()->crate_no;
       m_slot_no = wfptr->get_wib_header()->slot_no;
@@ -391,24 +457,135 @@ protected:
       TLOG() << "Got first item, fiber/crate/slot=" << m_fiber_no << "/" << m_crate_no << "/" << m_slot_no;
     }
 
-    m_coll_tpg_pi->input = &collection_registers;
+    // The induction registers are expanded in place into the queue of the induction hit finding
+    for (size_t i = 0; i < window; ++i) {
+      InductionItemToProcess* ind_item = nullptr;
+      if (m_induction_items_to_process->reserve(ind_item, 1) == 0) {
+        ind_item = &m_dummy_induction_item;
+        ++m_ind_items_dropped;
+      }
+      expand_message_adcs_inplace(fp + i, &m_coll_window_registers[i], &ind_item->registers);
+      if (ind_item != &m_dummy_induction_item) {
+        ind_item->timestamp = fp[i].get_first_timestamp();
+        m_induction_items_to_process->commit(1);
+      }
+    }
+    if (m_induction_strand != nullptr) {
+      m_induction_strand->notify();
+    } else {
+      m_induction_wait.notify();
+    }
+
+    if (m_first_coll) {
+      m_coll_tpg_pi->setState(m_coll_window_registers[0]);
+    }
+
+    m_coll_tpg_pi->input = &m_coll_window_registers[0];
+    m_coll_tpg_pi->timeWindowNumFrames = swtpg::FRAMES_PER_MSG * window;
     *m_coll_primfind_dest = swtpg::MAGIC;
     swtpg::process_window_avx2(*m_coll_tpg_pi);
 
+    unsigned int nhits = add_hits(m_coll_primfind_dest, timestamp, swtpg::collection_index_to_channel, m_first_coll);
+
+    m_num_hits_coll += nhits;
+    m_coll_hits_count += nhits;
+
+    if (m_first_coll) {
+      TLOG() << "Total hits in first superchunk: " << nhits;
+      m_first_coll = false;
+    }
+
+    // TPSets are sent up to where both planes are done
+    m_coll_done_ts.store(timestamp + (window - 1) * s_superchunk_ticks);
+    for (size_t i = 0; i < window; ++i) {
+      m_tphandler->try_sending_tpsets(std::min(timestamp + i * s_superchunk_ticks, m_ind_done_ts.load()));
+    }
+
+    m_coll_busy_ns +=
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+    m_coll_bytes += window * sizeof(types::WIB_SUPERCHUNK_STRUCT);
+  }
+
+  /**
+   * Pipeline Stage 4.: Do software TPG on the induction registers that find_collection_hits queued
+   * Induction signals are bipolar, the kernel finds hits in either polarity and keeps the two lobes together.
+   * Returns false when nothing was queued.
+   * */
+  bool find_induction_hits()
+  {
+    auto* item = m_induction_items_to_process->front();
+    if (item == nullptr) {
+      return false;
+    }
+    auto begin = std::chrono::steady_clock::now();
+
+    if (m_first_ind) {
+      m_ind_tpg_pi->setState(item->registers);
+    }
+
+    m_ind_tpg_pi->input = &item->registers;
+    *m_ind_primfind_dest = swtpg::MAGIC;
+    swtpg::process_window_avx2<swtpg::INDUCTION_REGISTERS_PER_FRAME, true>(*m_ind_tpg_pi);
+
+    unsigned int nhits =
+      add_hits(m_ind_primfind_dest, item->timestamp, swtpg::induction_index_to_channel, m_first_ind);
+
+    m_num_hits_ind += nhits;
+    m_indu_hits_count += nhits;
+
+    if (m_first_ind) {
+      TLOG() << "Total induction hits in first superchunk: " << nhits;
+      m_first_ind = false;
+    }
+
+    m_ind_done_ts.store(item->timestamp);
+    m_tphandler->try_sending_tpsets(std::min(item->timestamp, m_coll_done_ts.load()));
+    m_induction_items_to_process->popFront();
+
+    m_ind_busy_ns +=
+      std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count();
+    m_ind_bytes += sizeof(types::WIB_SUPERCHUNK_STRUCT);
+    return true;
+  }
+
+  void run_induction_thread()
+  {
+    while (m_run_marker.load() || !m_induction_items_to_process->isEmpty()) {
+      if (!find_induction_hits()) {
+        m_induction_wait.wait([&]() { return !m_induction_items_to_process->isEmpty() || !m_run_marker.load(); });
+      }
+    }
+  }
+
+  // A turn on the shared pool, true when items are left
+  bool run_induction_strand()
+  {
+    for (size_t i = 0; i < s_induction_items_per_turn; ++i) {
+      if (!find_induction_hits()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Turns the hits that process_window_avx2 left in primfind_it into TPs, returns the number of hits
+  unsigned int add_hits(const uint16_t* primfind_it, // NOLINT(build/unsigned)
+                        uint64_t timestamp,          // NOLINT(build/unsigned)
+                        chan_map_fn_t index_to_channel,
+                        bool first)
+  {
     uint16_t chan[16], hit_end[16], hit_charge[16], hit_tover[16]; // NOLINT(build/unsigned)
     unsigned int nhits = 0;
 
-    uint16_t* primfind_it = m_coll_primfind_dest; // NOLINT(build/unsigned)
-
     constexpr int clocksPerTPCTick = 25;
 
     // process_window_avx2 stores its output in the buffer pointed to
-    // by m_coll_primfind_dest in a (necessarily) complicated way: for
+    // by primfind_it in a (necessarily) complicated way: for
     // every set of 16 channels (one AVX2 register) that has at least
     // one hit which ends at this tick, the full 16-channel registers
     // of channel number, hit end time, hit charge and hit t-o-t are
-    // stored. This is done for each of the (6 collection registers
-    // per tick) x (12 ticks per superchunk), and the end of valid
+    // stored. This is done for each of the (6 collection or 10 induction
+    // registers per tick) x (12 ticks per superchunk), and the end of valid
     // hits is indicated by the presence of the value "MAGIC" (defined
     // in TPGConstants.h).
     //
@@ -439,10 +616,11 @@ protected:
       for (int i = 0; i < 16; ++i) {
         if (hit_charge[i] && chan[i] != swtpg::MAGIC) {
           // This channel had a hit ending here, so we can create and output the hit here
-          const uint16_t online_channel = swtpg::collection_index_to_channel(chan[i]); // NOLINT(build/unsigned)
-          uint64_t tp_t_begin =                                                        // NOLINT(build/unsigned)
-            timestamp + clocksPerTPCTick * (int64_t(hit_end[i]) - hit_tover[i]);       // NOLINT(build/unsigned)
-          uint64_t tp_t_end = timestamp + clocksPerTPCTick * int64_t(hit_end[i]);      // NOLINT(build/unsigned)
+          const uint16_t online_channel = index_to_channel(chan[i]); // NOLINT(build/unsigned)
+          // A bipolar hit may have ended in the previous window, its end time is negative then
+          const int64_t end_tick = static_cast<int16_t>(hit_end[i]);
+          uint64_t tp_t_begin = timestamp + clocksPerTPCTick * (end_tick - hit_tover[i]); // NOLINT(build/unsigned)
+          uint64_t tp_t_end = timestamp + clocksPerTPCTick * end_tick;                    // NOLINT(build/unsigned)
 
           // May be needed for TPSet:
           // uint64_t tspan = clocksPerTPCTick * hit_tover[i]; // is/will be this needed?
@@ -455,8 +633,6 @@ protected:
           //
           // TLOG() << "Hit: " << hit_start << " " << offline_channel;
 
-          // if (should_send) {
-          //
           triggeralgs::TriggerPrimitive trigprim;
           trigprim.time_start = tp_t_begin;
           trigprim.time_peak = (tp_t_begin + tp_t_end) / 2;
@@ -470,7 +646,7 @@ protected:
           trigprim.algorithm = triggeralgs::TriggerPrimitive::Algorithm::kTPCDefault;
           trigprim.version = 1;
 
-          if (m_first_coll) {
+          if (first) {
             TLOG() << "TP makes sense? -> hit_t_begin:" << tp_t_begin << " hit_t_end:" << tp_t_end
                    << " time_peak:" << (tp_t_begin + tp_t_end) / 2;
           }
@@ -479,43 +655,21 @@ protected:
             m_tps_dropped++;
           }
 
-          //} else {
-
-          //}
           m_new_tps++;
           ++nhits;
         }
       }
     }
-
-    // if (nhits > 0) {
-    // TLOG() << "NON null hits: " << nhits << " for ts: " << timestamp;
-    // TLOG() << *wfptr;
-    //}
-
-    m_num_hits_coll += nhits;
-    m_coll_hits_count += nhits;
-
-    if (m_first_coll) {
-      TLOG() << "Total hits in first superchunk: " << nhits;
-      m_first_coll = false;
-    }
-
-    m_tphandler->try_sending_tpsets(timestamp);
+    return nhits;
   }
 
-  // Stage: induction hit finding port
-  void find_induction_hits(frameptr /*fp*/)
+  // MB of raw data per second of processing time
+  static double throughput_mbs(std::atomic<uint64_t>& bytes,   // NOLINT(build/unsigned)
+                               std::atomic<uint64_t>& busy_ns) // NOLINT(build/unsigned)
   {
-    m_induction_items_to_process->popFront();
-
-    // while (m_running()) { // if spawned as thread.
-
-    // InductionItemToProcess item = nullptr;
-
-    // if (m_first_ind) {
-    //  m_ind_tpg_pi->setState(
-    //}
+    auto ns = busy_ns.exchange(0);
+    auto processed = bytes.exchange(0);
+    return ns == 0 ? 0. : processed * 1000. / ns;
   }
 
 private:
@@ -536,6 +690,10 @@ private:
   };
 
   std::unique_ptr<IterableQueueModel<InductionItemToProcess>> m_induction_items_to_process;
+  ReusableThread m_induction_thread{ 0 };
+  WaitStrategy m_induction_wait{ s_postprocess_sleep_time };
+  std::unique_ptr<WorkStealingExecutor::Strand> m_induction_strand;
+  static constexpr size_t s_induction_items_per_turn = 16;
 
   size_t m_num_msg = 0;
   size_t m_num_push_fail = 0;
@@ -567,6 +725,12 @@ private:
   int m_error_reset_freq;
 
   // Collection
+  // The hit output buffer holds the hits of 16 superchunks
+  static constexpr size_t s_max_window_superchunks = 16;
+  static constexpr uint64_t s_superchunk_ticks = 300; // NOLINT(build/unsigned)
+  size_t m_coll_window_superchunks = 1;
+  // Expanded registers of the window, one message after the other as process_window_avx2 expects them
+  std::unique_ptr<swtpg::MessageRegistersCollection[]> m_coll_window_registers;
   const uint16_t m_coll_threshold = 5;                    // units of sigma // NOLINT(build/unsigned)
   const uint8_t m_coll_tap_exponent = 6;                  // NOLINT(build/unsigned)
   const int m_coll_multiplier = 1 << m_coll_tap_exponent; // 64
@@ -577,12 +741,13 @@ private:
 
   // Induction
   const uint16_t m_ind_threshold = 3;                   // units of sigma // NOLINT(build/unsigned)
+  const int16_t m_ind_hold_ticks = 4;                   // ticks between the lobes of a bipolar hit
   const uint8_t m_ind_tap_exponent = 6;                 // NOLINT(build/unsigned)
   const int m_ind_multiplier = 1 << m_ind_tap_exponent; // 64
   std::vector<int16_t> m_ind_taps;                      // firwin_int(7, 0.1, multiplier);
   uint16_t* m_ind_primfind_dest;                        // NOLINT(build/unsigned)
   int16_t* m_ind_taps_p;
-  std::unique_ptr<swtpg::ProcessingInfo<swtpg::REGISTERS_PER_FRAME>> m_ind_tpg_pi;
+  std::unique_ptr<swtpg::ProcessingInfo<swtpg::INDUCTION_REGISTERS_PER_FRAME>> m_ind_tpg_pi;
 
   std::unique_ptr<appfwk::DAQSink<types::SW_WIB_TRIGGERPRIMITIVE_STRUCT>> m_tp_sink;
   std::unique_ptr<appfwk::DAQSink<trigger::TPSet>> m_tpset_sink;
@@ -598,6 +763,17 @@ private:
   std::atomic<uint64_t> m_new_tps{ 0 };     // NOLINT(build/unsigned)
   std::atomic<uint64_t> m_tps_dropped{ 0 };
 
+  // TPSets are only sent for times that both planes are done with
+  std::atomic<uint64_t> m_coll_done_ts{ 0 }; // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_ind_done_ts{ 0 };  // NOLINT(build/unsigned)
+
+  // Throughput of the hit finding: raw data processed and time spent on it
+  std::atomic<uint64_t> m_coll_busy_ns{ 0 };       // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_coll_bytes{ 0 };         // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_ind_busy_ns{ 0 };        // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_ind_bytes{ 0 };          // NOLINT(build/unsigned)
+  std::atomic<uint64_t> m_ind_items_dropped{ 0 };  // NOLINT(build/unsigned)
+
   std::chrono::time_point<std::chrono::high_resolution_clock> m_t0;
 };
 
@@ -76,7 +76,10 @@ frugal_accum_update_avx2(__m256i& __restrict__ median,
   accum = _mm256_blendv_epi8(accum, _mm256_setzero_si256(), need_reset);
 }
 
-template<size_t NREGISTERS>
+// BIPOLAR finds hits on induction channels: samples over threshold in either polarity count, and a hit
+// is held open for info.hold_ticks below threshold, so that the zero crossing between the two lobes of
+// an induction signal does not split it. The charge is the integral of the magnitude of both lobes.
+template<size_t NREGISTERS, bool BIPOLAR = false>
 inline void
 process_window_avx2(ProcessingInfo<NREGISTERS>& info)
 {
@@ -102,6 +105,11 @@ process_window_avx2(ProcessingInfo<NREGISTERS>& info)
 
   const __m256i iota = _mm256_set_epi16(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
 
+  // Bipolar hit finding: the threshold scale, and the hold counter a sample over threshold sets
+  const __m256i threshold_scale = _mm256_set1_epi16(info.multiplier * info.threshold);
+  const __m256i hold_ticks = _mm256_set1_epi16(info.hold_ticks);
+  const __m256i hold_start = _mm256_set1_epi16(info.hold_ticks + 1);
+
   int nhits = 0;
 
   for (uint16_t ireg = info.first_register; ireg < info.last_register; ++ireg) { // NOLINT(build/unsigned)
@@ -146,6 +154,8 @@ process_window_avx2(ProcessingInfo<NREGISTERS>& info)
     // The time-over-threshold (so far) of the current hit
     __m256i hit_tover = _mm256_lddqu_si256(reinterpret_cast<__m256i*>(state.hit_tover) + ireg); // NOLINT
     ;
+    // Ticks left before an open bipolar hit ends, 0 outside of a hit
+    __m256i hit_hold = _mm256_lddqu_si256(reinterpret_cast<__m256i*>(state.hit_hold) + ireg); // NOLINT
 
     // The channel numbers in each of the slots in the register
     __m256i channel_base = _mm256_set1_epi16(ireg * SAMPLES_PER_REGISTER);
@@ -263,9 +273,26 @@ process_window_avx2(ProcessingInfo<NREGISTERS>& info)
       // --------------------------------------------------------------
       // Mask for channels that are over the threshold in this step
       // const uint16_t threshold=2000; // NOLINT(build/unsigned)
-      __m256i is_over = _mm256_cmpgt_epi16(filt, sigma * info.multiplier * info.threshold);
+      __m256i is_over;
       // Mask for channels that left "over threshold" state this step
-      __m256i left = _mm256_andnot_si256(is_over, prev_was_over);
+      __m256i left;
+      // Mask for channels that are in a hit after this step
+      __m256i in_hit;
+      if constexpr (BIPOLAR) {
+        const __m256i threshold = _mm256_mullo_epi16(sigma, threshold_scale);
+        is_over = _mm256_or_si256(_mm256_cmpgt_epi16(filt, threshold),
+                                  _mm256_cmpgt_epi16(_mm256_sub_epi16(_mm256_setzero_si256(), filt), threshold));
+        hit_hold = _mm256_blendv_epi8(
+          _mm256_max_epi16(_mm256_sub_epi16(hit_hold, _mm256_set1_epi16(1)), _mm256_setzero_si256()),
+          hold_start,
+          is_over);
+        in_hit = _mm256_cmpgt_epi16(hit_hold, _mm256_setzero_si256());
+        left = _mm256_andnot_si256(in_hit, prev_was_over);
+      } else {
+        is_over = _mm256_cmpgt_epi16(filt, sigma * info.multiplier * info.threshold);
+        left = _mm256_andnot_si256(is_over, prev_was_over);
+        in_hit = is_over;
+      }
 
       //-----------------------------------------
       // Update hit start times for the channels where a hit started
@@ -276,7 +303,8 @@ process_window_avx2(ProcessingInfo<NREGISTERS>& info)
       // Really want an epi16 version of this, but the cmpgt and
       // cmplt functions set their epi16 parts to 0xff or 0x0,
       // so treating everything as epi8 works the same
-      __m256i to_add_charge = _mm256_blendv_epi8(_mm256_set1_epi16(0), filt, is_over);
+      __m256i to_add_charge =
+        _mm256_blendv_epi8(_mm256_set1_epi16(0), BIPOLAR ? _mm256_abs_epi16(filt) : filt, is_over);
       // Divide by the multiplier before adding (implemented as a shift-right)
       hit_charge = _mm256_adds_epi16(hit_charge, _mm256_srai_epi16(to_add_charge, info.tap_exponent));
 
@@ -291,7 +319,8 @@ process_window_avx2(ProcessingInfo<NREGISTERS>& info)
       //     printf("left:          "); print256_as16_dec(left);          printf("\n");
       // }
 
-      __m256i to_add_tover = _mm256_blendv_epi8(_mm256_set1_epi16(0), _mm256_set1_epi16(1), is_over);
+      // A bipolar hit counts the ticks it is held open too, they are taken off when it is stored
+      __m256i to_add_tover = _mm256_blendv_epi8(_mm256_set1_epi16(0), _mm256_set1_epi16(1), in_hit);
       hit_tover = _mm256_adds_epi16(hit_tover, to_add_tover);
 
       // Only store the values if there are >0 hits ending on
@@ -326,12 +355,16 @@ process_window_avx2(ProcessingInfo<NREGISTERS>& info)
         // the caller. This saves faffing with hits that span
         // a message boundary, hopefully
 
-        _mm256_storeu_si256(output_loc++, timenow); // NOLINT(runtime/increment_decrement)
+        //
+        // A bipolar hit ended hold_ticks before it is stored, the end time may be negative then.
+        _mm256_storeu_si256(output_loc++, // NOLINT(runtime/increment_decrement)
+                            BIPOLAR ? _mm256_sub_epi16(timenow, hold_ticks) : timenow);
         // STORE_MASK(hit_charge);
         _mm256_storeu_si256(
           output_loc++, // NOLINT(runtime/increment_decrement)
           _mm256_blendv_epi8(_mm256_set1_epi16(0), hit_charge, left));
-        _mm256_storeu_si256(output_loc++, hit_tover);                  // NOLINT(runtime/increment_decrement)
+        _mm256_storeu_si256(output_loc++, // NOLINT(runtime/increment_decrement)
+                            BIPOLAR ? _mm256_sub_epi16(hit_tover, hold_ticks) : hit_tover);
 
         // reset hit_start, hit_charge and hit_tover in the channels we saved
         const __m256i zero = _mm256_setzero_si256();
@@ -339,7 +372,7 @@ process_window_avx2(ProcessingInfo<NREGISTERS>& info)
         hit_tover = _mm256_blendv_epi8(hit_tover, zero, left);
       } // end if(!no_hits_to_store)
 
-      prev_was_over = is_over;
+      prev_was_over = in_hit;
 
     } // end loop over itime (times for this register)
 
@@ -359,6 +392,7 @@ process_window_avx2(ProcessingInfo<NREGISTERS>& info)
     _mm256_storeu_si256(reinterpret_cast<__m256i*>(state.prev_was_over) + ireg, prev_was_over); // NOLINT
     _mm256_storeu_si256(reinterpret_cast<__m256i*>(state.hit_charge) + ireg, hit_charge);       // NOLINT
     _mm256_storeu_si256(reinterpret_cast<__m256i*>(state.hit_tover) + ireg, hit_tover);         // NOLINT
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(state.hit_hold) + ireg, hit_hold);           // NOLINT
 
   } // end loop over ireg (the 8 registers in this frame)
 
@@ -30,6 +30,7 @@ struct ChanState
       prev_was_over[i] = 0;
       hit_charge[i] = 0;
       hit_tover[i] = 0;
+      hit_hold[i] = 0;
       for (size_t j = 0; j < NTAPS; ++j) {
         prev_samp[i * NTAPS + j] = 0;
       }
@@ -55,6 +56,7 @@ struct ChanState
     __restrict__ prev_was_over[NREGISTERS * SAMPLES_PER_REGISTER]; // was the previous sample over threshold?
   alignas(32) int16_t __restrict__ hit_charge[NREGISTERS * SAMPLES_PER_REGISTER];
   alignas(32) int16_t __restrict__ hit_tover[NREGISTERS * SAMPLES_PER_REGISTER]; // time over threshold
+  alignas(32) int16_t __restrict__ hit_hold[NREGISTERS * SAMPLES_PER_REGISTER];  // ticks a bipolar hit stays open
 };
 
 template<size_t NREGISTERS>
@@ -113,6 +115,8 @@ struct ProcessingInfo
   int16_t adcMax;
   size_t nhits;
   uint16_t absTimeModNTAPS; // NOLINT
+  // Ticks below threshold that do not end a hit, for bipolar (induction) hit finding
+  int16_t hold_ticks = 0;
   ChanState<NREGISTERS> chanState;
 };
 
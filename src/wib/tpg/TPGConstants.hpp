@@ -32,6 +32,10 @@ const constexpr std::size_t FRAMES_PER_MSG = 12;
 // frame.
 const constexpr std::size_t REGISTERS_PER_FRAME = 6;
 
+// How many induction-wire AVX2 registers are returned per
+// frame.
+const constexpr std::size_t INDUCTION_REGISTERS_PER_FRAME = 10;
+
 // How many bytes are in an AVX2 register
 const constexpr std::size_t BYTES_PER_REGISTER = 32;
 
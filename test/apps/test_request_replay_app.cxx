@@ -0,0 +1,286 @@
+/**
+ * @file test_request_replay_app.cxx Benchmark of the request handler models
+ * Pre-fills the latency buffer of each LB/RH combination used by createReadout with synthetic
+ * superchunks, then replays a DataRequest trace while a producer keeps writing. Reports the
+ * request rate, the response latency percentiles and how much the buffer cleanups slow down
+ * the requests they overlap with.
+ *
+ * Usage: readout_test_request_replay [request rate Hz] [request threads] [seconds] [trace file]
+ * Every line of the trace file holds the distance of a window end behind the newest element,
+ * and the window width, both in ticks. Without it a fixed window is requested.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+#include "readout/models/BinarySearchQueueModel.hpp"
+#include "readout/models/DefaultRequestHandlerModel.hpp"
+#include "readout/models/FixedRateQueueModel.hpp"
+#include "readout/models/ZeroCopyRecordingRequestHandlerModel.hpp"
+#include "readout/utils/LatencyHistogram.hpp"
+#include "readout/utils/RateLimiter.hpp"
+
+#include "readout/FrameErrorRegistry.hpp"
+#include "readout/ReadoutTypes.hpp"
+#include "readout/readoutconfig/Nljs.hpp"
+
+#include "appfwk/DAQSink.hpp"
+#include "appfwk/DAQSource.hpp"
+#include "appfwk/QueueRegistry.hpp"
+#include "daqdataformats/Fragment.hpp"
+#include "dfmessages/DataRequest.hpp"
+#include "logging/Logging.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace dunedaq::readout;
+using namespace dunedaq;
+
+namespace {
+
+using fragment_ptr_t = std::unique_ptr<daqdataformats::Fragment>;
+using bench_clock = std::chrono::steady_clock;
+
+struct BenchmarkConf
+{
+  double request_rate_hz = 1000;
+  int request_threads = 4;
+  int run_seconds = 10;
+  double element_rate_khz = 166;
+  size_t latency_buffer_size = 100000;
+  std::vector<std::pair<uint64_t, uint64_t>> trace; // NOLINT(build/unsigned)
+};
+
+std::string
+percentiles(const LatencyHistogram::Summary& summary)
+{
+  return "p50=" + std::to_string(summary.p50 / 1000) + " p99=" + std::to_string(summary.p99 / 1000) +
+         " p999=" + std::to_string(summary.p999 / 1000) + " max=" + std::to_string(summary.max / 1000) + " [us]";
+}
+
+// Counts and times the cleanups, so that requests running at the same time can be told apart
+template<class RequestHandlerType>
+class TimedCleanupRequestHandler : public RequestHandlerType
+{
+public:
+  using RequestHandlerType::RequestHandlerType;
+
+  std::atomic<uint64_t> cleanups_started{ 0 };  // NOLINT(build/unsigned)
+  std::atomic<uint64_t> cleanups_finished{ 0 }; // NOLINT(build/unsigned)
+  LatencyHistogram cleanup_histogram;
+
+protected:
+  void cleanup() override
+  {
+    auto begin = bench_clock::now();
+    ++cleanups_started;
+    RequestHandlerType::cleanup();
+    ++cleanups_finished;
+    cleanup_histogram.record(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - begin).count());
+  }
+};
+
+template<class ReadoutType>
+ReadoutType
+make_element(uint64_t timestamp) // NOLINT(build/unsigned)
+{
+  ReadoutType element;
+  element.set_first_timestamp(timestamp);
+  element.fake_timestamps(timestamp, ReadoutType::expected_tick_difference);
+  return element;
+}
+
+template<class ReadoutType, class LatencyBufferType, class RequestHandlerType>
+void
+run_benchmark(const std::string& name, const BenchmarkConf& bench_conf)
+{
+  TLOG() << "=== " << name;
+  readoutconfig::Conf conf;
+  conf.latencybufferconf.latency_buffer_size = bench_conf.latency_buffer_size;
+  conf.requesthandlerconf.latency_buffer_size = bench_conf.latency_buffer_size;
+  conf.requesthandlerconf.num_request_handling_threads = bench_conf.request_threads;
+  conf.requesthandlerconf.enable_raw_recording = false;
+  nlohmann::json args;
+  readoutconfig::to_json(args, conf);
+
+  std::unique_ptr<LatencyBufferType> latency_buffer(new LatencyBufferType());
+  std::unique_ptr<FrameErrorRegistry> error_registry(new FrameErrorRegistry());
+  TimedCleanupRequestHandler<RequestHandlerType> request_handler(latency_buffer, error_registry);
+  latency_buffer->conf(args);
+  request_handler.init(args);
+  request_handler.conf(args);
+
+  // Fill up to the cleanup limit, so that the producer triggers cleanups right away
+  uint64_t tick_step = ReadoutType::expected_tick_difference * make_element<ReadoutType>(0).get_num_frames(); // NOLINT
+  std::atomic<uint64_t> newest_timestamp{ 0 }; // NOLINT(build/unsigned)
+  uint64_t timestamp = tick_step;               // NOLINT(build/unsigned)
+  for (size_t i = 0; i < bench_conf.latency_buffer_size * conf.requesthandlerconf.pop_limit_pct; ++i) {
+    latency_buffer->write(make_element<ReadoutType>(timestamp));
+    newest_timestamp = timestamp;
+    timestamp += tick_step;
+  }
+
+  appfwk::DAQSink<fragment_ptr_t> fragment_sink("fragments");
+  appfwk::DAQSource<fragment_ptr_t> fragment_source("fragments");
+  request_handler.start(args);
+
+  std::atomic<bool> marker{ true };
+  size_t max_requests = static_cast<size_t>(bench_conf.request_rate_hz * bench_conf.run_seconds) + 1;
+  std::vector<bench_clock::time_point> issue_times(max_requests);
+  std::vector<uint64_t> issue_cleanups(max_requests); // NOLINT(build/unsigned)
+  std::atomic<size_t> issued{ 0 };
+  std::atomic<size_t> received{ 0 };
+
+  auto producer = std::thread([&]() {
+    RateLimiter limiter(bench_conf.element_rate_khz);
+    uint64_t ts = timestamp; // NOLINT(build/unsigned)
+    while (marker) {
+      if (latency_buffer->write(make_element<ReadoutType>(ts))) {
+        newest_timestamp = ts;
+        request_handler.notify_newest_timestamp(ts);
+      }
+      ts += tick_step;
+      limiter.limit();
+    }
+  });
+
+  // Windows default to 10 elements, a quarter of the buffered data behind the newest one
+  uint64_t default_delay = bench_conf.latency_buffer_size / 8 * tick_step; // NOLINT(build/unsigned)
+  uint64_t default_width = 10 * tick_step;                                // NOLINT(build/unsigned)
+  auto replayer = std::thread([&]() {
+    RateLimiter limiter(bench_conf.request_rate_hz / 1000.);
+    while (marker && issued < max_requests) {
+      size_t id = issued;
+      auto delay = bench_conf.trace.empty() ? default_delay : bench_conf.trace[id % bench_conf.trace.size()].first;
+      auto width = bench_conf.trace.empty() ? default_width : bench_conf.trace[id % bench_conf.trace.size()].second;
+      dfmessages::DataRequest request;
+      request.trigger_number = id;
+      uint64_t newest = newest_timestamp; // NOLINT(build/unsigned)
+      request.window_end = newest > delay + width ? newest - delay : width;
+      request.window_begin = request.window_end - width;
+      request.trigger_timestamp = request.window_begin + width / 2;
+      issue_times[id] = bench_clock::now();
+      issue_cleanups[id] = request_handler.cleanups_finished;
+      issued = id + 1;
+      request_handler.issue_request(request, fragment_sink);
+      limiter.limit();
+    }
+  });
+
+  LatencyHistogram latency_histogram;
+  LatencyHistogram overlapping_histogram;
+  LatencyHistogram clear_histogram;
+  size_t empty_fragments = 0;
+  auto drainer = std::thread([&]() {
+    while (marker || received < issued) {
+      fragment_ptr_t fragment;
+      try {
+        fragment_source.pop(fragment, std::chrono::milliseconds(100));
+      } catch (const appfwk::QueueTimeoutExpired&) {
+        if (!marker) {
+          break;
+        }
+        continue;
+      }
+      auto id = fragment->get_trigger_number();
+      uint64_t took = // NOLINT(build/unsigned)
+        std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - issue_times[id]).count();
+      latency_histogram.record(took);
+      // A cleanup started before the response and finished after the request overlapped with it
+      if (request_handler.cleanups_started > issue_cleanups[id]) {
+        overlapping_histogram.record(took);
+      } else {
+        clear_histogram.record(took);
+      }
+      if (fragment->get_size() == sizeof(daqdataformats::FragmentHeader)) {
+        ++empty_fragments;
+      }
+      ++received;
+    }
+  });
+
+  auto begin = bench_clock::now();
+  std::this_thread::sleep_for(std::chrono::seconds(bench_conf.run_seconds));
+  auto requests_done = received.load();
+  double seconds = std::chrono::duration_cast<std::chrono::microseconds>(bench_clock::now() - begin).count() / 1e6;
+  marker = false;
+  producer.join();
+  replayer.join();
+  drainer.join();
+  request_handler.stop(args);
+
+  auto overlapping = overlapping_histogram.get_and_reset();
+  auto clear = clear_histogram.get_and_reset();
+  auto cleanups = request_handler.cleanup_histogram.get_and_reset();
+  TLOG() << name << ": " << requests_done / seconds << " requests/s, " << empty_fragments << " empty fragments";
+  TLOG() << name << ": latency " << percentiles(latency_histogram.get_and_reset());
+  TLOG() << name << ": " << cleanups.count << " cleanups " << percentiles(cleanups);
+  TLOG() << name << ": " << overlapping.count << " requests during cleanups " << percentiles(overlapping);
+  TLOG() << name << ": " << clear.count << " requests between cleanups " << percentiles(clear);
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  BenchmarkConf bench_conf;
+  if (argc > 1) {
+    bench_conf.request_rate_hz = std::stod(argv[1]);
+  }
+  if (argc > 2) {
+    bench_conf.request_threads = std::stoi(argv[2]);
+  }
+  if (argc > 3) {
+    bench_conf.run_seconds = std::stoi(argv[3]);
+  }
+  if (argc > 4) {
+    std::ifstream trace_file(argv[4]);
+    uint64_t delay = 0; // NOLINT(build/unsigned)
+    uint64_t width = 0; // NOLINT(build/unsigned)
+    while (trace_file >> delay >> width) {
+      bench_conf.trace.emplace_back(delay, width);
+    }
+    TLOG() << "Replaying " << bench_conf.trace.size() << " requests from " << argv[4];
+  }
+
+  std::map<std::string, appfwk::QueueConfig> queue_map = {
+    { "fragments", { appfwk::QueueConfig::queue_kind::kFollyMPMCQueue, 100000 } }
+  };
+  appfwk::QueueRegistry::get().configure(queue_map);
+
+  TLOG() << "Replaying requests at " << bench_conf.request_rate_hz << " Hz on " << bench_conf.request_threads
+         << " request threads for " << bench_conf.run_seconds << " s per combination";
+
+  run_benchmark<types::WIB_SUPERCHUNK_STRUCT,
+                FixedRateQueueModel<types::WIB_SUPERCHUNK_STRUCT>,
+                ZeroCopyRecordingRequestHandlerModel<types::WIB_SUPERCHUNK_STRUCT,
+                                                     FixedRateQueueModel<types::WIB_SUPERCHUNK_STRUCT>>>(
+    "WIB ZeroCopyRecording/FixedRateQueue", bench_conf);
+  run_benchmark<types::WIB2_SUPERCHUNK_STRUCT,
+                FixedRateQueueModel<types::WIB2_SUPERCHUNK_STRUCT>,
+                DefaultRequestHandlerModel<types::WIB2_SUPERCHUNK_STRUCT,
+                                           FixedRateQueueModel<types::WIB2_SUPERCHUNK_STRUCT>>>(
+    "WIB2 Default/FixedRateQueue", bench_conf);
+  run_benchmark<types::DAPHNE_SUPERCHUNK_STRUCT,
+                BinarySearchQueueModel<types::DAPHNE_SUPERCHUNK_STRUCT>,
+                DefaultRequestHandlerModel<types::DAPHNE_SUPERCHUNK_STRUCT,
+                                           BinarySearchQueueModel<types::DAPHNE_SUPERCHUNK_STRUCT>>>(
+    "DAPHNE Default/BinarySearchQueue", bench_conf);
+  run_benchmark<types::SSP_FRAME_STRUCT,
+                BinarySearchQueueModel<types::SSP_FRAME_STRUCT>,
+                DefaultRequestHandlerModel<types::SSP_FRAME_STRUCT, BinarySearchQueueModel<types::SSP_FRAME_STRUCT>>>(
+    "SSP Default/BinarySearchQueue", bench_conf);
+
+  TLOG() << "Exiting.";
+  return 0;
+}
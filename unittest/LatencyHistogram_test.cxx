@@ -0,0 +1,92 @@
+/**
+ * @file LatencyHistogram_test.cxx Unit Tests for the LatencyHistogram
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE LatencyHistogram_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include "logging/Logging.hpp"
+#include "readout/utils/LatencyHistogram.hpp"
+
+#include <thread>
+#include <vector>
+
+using namespace dunedaq::readout;
+
+BOOST_AUTO_TEST_SUITE(LatencyHistogram_test)
+
+// Reported values are bucket tops, at most 2/s_sub_buckets above the recorded value
+void
+check_close(uint64_t reported, uint64_t expected) // NOLINT(build/unsigned)
+{
+  BOOST_REQUIRE_GE(reported, expected);
+  BOOST_REQUIRE_LE(reported, expected + expected * 2 / LatencyHistogram::s_sub_buckets);
+}
+
+BOOST_AUTO_TEST_CASE(LatencyHistogram_percentiles)
+{
+  TLOG() << "Record a uniform distribution and check its percentiles" << std::endl;
+  LatencyHistogram histogram;
+  for (uint64_t value = 1; value <= 100000; ++value) { // NOLINT(build/unsigned)
+    histogram.record(value);
+  }
+  auto summary = histogram.get_and_reset();
+  BOOST_REQUIRE_EQUAL(summary.count, 100000);
+  BOOST_REQUIRE_EQUAL(summary.max, 100000);
+  check_close(summary.p50, 50000);
+  check_close(summary.p99, 99000);
+  check_close(summary.p999, 99900);
+
+  auto empty = histogram.get_and_reset();
+  BOOST_REQUIRE_EQUAL(empty.count, 0);
+  BOOST_REQUIRE_EQUAL(empty.max, 0);
+  BOOST_REQUIRE_EQUAL(empty.p50, 0);
+
+  histogram.record(uint64_t(1) << 50); // NOLINT(build/unsigned)
+  BOOST_REQUIRE_EQUAL(histogram.get_and_reset().p999, uint64_t(1) << 50); // NOLINT(build/unsigned)
+}
+
+BOOST_AUTO_TEST_CASE(LatencyHistogram_small_values)
+{
+  TLOG() << "Values below the number of sub buckets are exact" << std::endl;
+  LatencyHistogram histogram;
+  for (uint64_t value = 0; value < LatencyHistogram::s_sub_buckets; ++value) { // NOLINT(build/unsigned)
+    histogram.record(value, 10);
+  }
+  auto summary = histogram.get_and_reset();
+  BOOST_REQUIRE_EQUAL(summary.count, 10 * LatencyHistogram::s_sub_buckets);
+  BOOST_REQUIRE_EQUAL(summary.p50, LatencyHistogram::s_sub_buckets / 2 - 1);
+  BOOST_REQUIRE_EQUAL(summary.max, LatencyHistogram::s_sub_buckets - 1);
+}
+
+BOOST_AUTO_TEST_CASE(LatencyHistogram_threads)
+{
+  TLOG() << "Record from several threads at once" << std::endl;
+  LatencyHistogram histogram;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([&histogram, i]() {
+      for (uint64_t value = 0; value < 10000; ++value) { // NOLINT(build/unsigned)
+        histogram.record(1000 * (i + 1));
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto summary = histogram.get_and_reset();
+  BOOST_REQUIRE_EQUAL(summary.count, 40000);
+  BOOST_REQUIRE_EQUAL(summary.max, 4000);
+  check_close(summary.p50, 2000);
+  check_close(summary.p99, 4000);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
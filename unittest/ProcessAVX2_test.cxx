@@ -0,0 +1,141 @@
+/**
+ * @file ProcessAVX2_test.cxx Unit Tests for the AVX2 hit finding
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE ProcessAVX2_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include "logging/Logging.hpp"
+#include "wib/tpg/ProcessAVX2.hpp"
+
+#include <ostream>
+#include <vector>
+
+using namespace swtpg;
+
+namespace {
+
+constexpr size_t s_num_registers = 2;
+constexpr int s_num_messages = 40;
+
+struct Hit
+{
+  int channel;
+  int end_time; // in ticks since the first message
+  int charge;
+  int tover;
+};
+
+bool
+operator!=(const Hit& left, const Hit& right)
+{
+  return left.channel != right.channel || left.end_time != right.end_time || left.charge != right.charge ||
+         left.tover != right.tover;
+}
+
+std::ostream&
+operator<<(std::ostream& out, const Hit& hit)
+{
+  return out << "{ " << hit.channel << ", " << hit.end_time << ", " << hit.charge << ", " << hit.tover << " }";
+}
+
+// A pulse of height ADC counts on one channel, from start_tick up to end_tick
+struct Pulse
+{
+  int channel;
+  int start_tick;
+  int end_tick;
+  int height;
+};
+
+// Runs the hit finding over messages with a fixed pattern of small noise on a pedestal of 500, plus the pulses
+template<bool BIPOLAR>
+std::vector<Hit>
+find_hits(const std::vector<Pulse>& pulses, int16_t hold_ticks = 0)
+{
+  static RegisterArray<s_num_registers * FRAMES_PER_MSG> input;
+  std::vector<uint16_t> output(10000); // NOLINT(build/unsigned)
+  int16_t taps[8] = { 2, 6, 12, 16, 12, 6, 2, 0 };
+  ProcessingInfo<s_num_registers> info(nullptr, FRAMES_PER_MSG, 0, s_num_registers, output.data(), taps, 8, 6, 5, 0, 0);
+  info.hold_ticks = hold_ticks;
+
+  std::vector<Hit> hits;
+  for (int msg = 0; msg < s_num_messages; ++msg) {
+    for (size_t ireg = 0; ireg < s_num_registers; ++ireg) {
+      for (size_t itime = 0; itime < FRAMES_PER_MSG; ++itime) {
+        for (size_t ichan = 0; ichan < SAMPLES_PER_REGISTER; ++ichan) {
+          int tick = msg * FRAMES_PER_MSG + itime;
+          int channel = ireg * SAMPLES_PER_REGISTER + ichan;
+          int adc = 500 + (tick * 7 + channel * 3) % 5 - 2;
+          for (auto& pulse : pulses) {
+            if (pulse.channel == channel && tick >= pulse.start_tick && tick < pulse.end_tick) {
+              adc += pulse.height;
+            }
+          }
+          input.set_uint16((ireg * FRAMES_PER_MSG + itime) * SAMPLES_PER_REGISTER + ichan, adc);
+        }
+      }
+    }
+    if (msg == 0) {
+      info.setState(input);
+    }
+    info.input = &input;
+    output[0] = MAGIC;
+    process_window_avx2<s_num_registers, BIPOLAR>(info);
+
+    // Every stored register holds the channels, end times, charges and times over threshold of 16 channels
+    for (uint16_t* out = output.data(); *out != MAGIC; out += 4 * SAMPLES_PER_REGISTER) { // NOLINT(build/unsigned)
+      for (size_t i = 0; i < SAMPLES_PER_REGISTER; ++i) {
+        if (out[2 * SAMPLES_PER_REGISTER + i] != 0) {
+          hits.push_back({ out[i],
+                           msg * static_cast<int>(FRAMES_PER_MSG) + static_cast<int16_t>(out[SAMPLES_PER_REGISTER + i]),
+                           out[2 * SAMPLES_PER_REGISTER + i],
+                           static_cast<int16_t>(out[3 * SAMPLES_PER_REGISTER + i]) });
+        }
+      }
+    }
+  }
+  return hits;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(ProcessAVX2_test)
+
+BOOST_AUTO_TEST_CASE(ProcessAVX2_collection)
+{
+  TLOG() << "Collection hits are the ones the kernel found before bipolar hit finding was added" << std::endl;
+  auto hits = find_hits<false>({ { 5, 100, 106, 200 }, { 21, 250, 253, 400 }, { 30, 358, 364, 100 } });
+  std::vector<Hit> expected{ { 5, 113, 1033, 10 }, { 21, 260, 1023, 7 }, { 30, 370, 491, 8 } };
+  BOOST_CHECK_EQUAL_COLLECTIONS(hits.begin(), hits.end(), expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(ProcessAVX2_bipolar)
+{
+  TLOG() << "The two lobes of an induction pulse are one hit, that ends on the last tick over threshold" << std::endl;
+  // A positive lobe, three ticks on the pedestal and a negative lobe
+  std::vector<Pulse> pulse{ { 19, 200, 206, 200 }, { 19, 209, 215, -200 } };
+
+  // Without holding, the filtered signal drops below threshold once between the lobes
+  auto split = find_hits<true>(pulse);
+  std::vector<Hit> lobes{ { 19, 212, 1001, 9 }, { 19, 222, 1002, 9 } };
+  BOOST_CHECK_EQUAL_COLLECTIONS(split.begin(), split.end(), lobes.begin(), lobes.end());
+
+  // The hit is stored when the hold runs out, with the end time and time over threshold of its last tick over
+  auto held = find_hits<true>(pulse, 4);
+  std::vector<Hit> hit{ { 19, 222, 2003, 19 } };
+  BOOST_REQUIRE_EQUAL(held.size(), 1);
+  BOOST_CHECK_EQUAL_COLLECTIONS(held.begin(), held.end(), hit.begin(), hit.end());
+  BOOST_REQUIRE_EQUAL(held[0].end_time - held[0].tover + 1, lobes[0].end_time - lobes[0].tover + 1);
+  BOOST_REQUIRE_EQUAL(held[0].charge, lobes[0].charge + lobes[1].charge);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,151 @@
+/**
+ * @file SpmcRing_test.cxx Unit Tests for the SpmcRing
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE SpmcRing_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include "logging/Logging.hpp"
+#include "readout/utils/SpmcRing.hpp"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq::readout;
+
+BOOST_AUTO_TEST_SUITE(SpmcRing_test)
+
+BOOST_AUTO_TEST_CASE(SpmcRing_cursors)
+{
+  TLOG() << "Every consumer reads every entry, the slowest one holds back the producer" << std::endl;
+  SpmcRing<int> ring(3, 2);
+  BOOST_REQUIRE_EQUAL(ring.capacity(), 4);
+  BOOST_REQUIRE_EQUAL(ring.oldest_pending_stamp(), SpmcRing<int>::s_no_stamp);
+
+  for (int i = 0; i < 4; ++i) {
+    BOOST_REQUIRE(ring.try_write(i, 100 + i));
+  }
+  BOOST_REQUIRE(!ring.try_write(4, 104));
+  BOOST_REQUIRE_EQUAL(ring.oldest_pending_stamp(), 100);
+
+  int entry = -1;
+  for (int i = 0; i < 4; ++i) {
+    BOOST_REQUIRE(ring.try_read(0, entry));
+    BOOST_REQUIRE_EQUAL(entry, i);
+    ring.advance(0);
+  }
+  BOOST_REQUIRE(ring.empty(0));
+  BOOST_REQUIRE(!ring.try_read(0, entry));
+  BOOST_REQUIRE_EQUAL(ring.slowest_consumer(), 1);
+  BOOST_REQUIRE(!ring.try_write(4, 104));
+  BOOST_REQUIRE_EQUAL(ring.oldest_pending_stamp(), 100);
+
+  BOOST_REQUIRE(ring.try_read(1, entry));
+  BOOST_REQUIRE_EQUAL(entry, 0);
+  ring.advance(1);
+  BOOST_REQUIRE_EQUAL(ring.oldest_pending_stamp(), 101);
+  BOOST_REQUIRE(ring.try_write(4, 104));
+}
+
+BOOST_AUTO_TEST_CASE(SpmcRing_threads)
+{
+  TLOG() << "One producer and three consumers in their own threads" << std::endl;
+  constexpr int num_entries = 100000;
+  constexpr int num_consumers = 3;
+  SpmcRing<int> ring(64, num_consumers);
+  // Boost checks are not thread safe, the consumers count what is out of order
+  std::vector<int> out_of_order(num_consumers, 0);
+  std::vector<std::thread> consumers;
+  for (int c = 0; c < num_consumers; ++c) {
+    consumers.emplace_back([&ring, &out_of_order, c]() {
+      int expected = 0;
+      while (expected < num_entries) {
+        int entry = 0;
+        if (ring.try_read(c, entry)) {
+          if (entry != expected) {
+            ++out_of_order[c];
+          }
+          ++expected;
+          ring.advance(c);
+        } else {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (int i = 0; i < num_entries;) {
+    if (ring.try_write(i, i)) {
+      ++i;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  for (auto& consumer : consumers) {
+    consumer.join();
+  }
+  for (auto count : out_of_order) {
+    BOOST_REQUIRE_EQUAL(count, 0);
+  }
+  BOOST_REQUIRE_EQUAL(ring.oldest_pending_stamp(), SpmcRing<int>::s_no_stamp);
+}
+
+BOOST_AUTO_TEST_CASE(SpmcRing_barrier)
+{
+  TLOG() << "The oldest pending stamp is never newer than an entry a consumer still holds" << std::endl;
+  constexpr int num_entries = 200000;
+  constexpr int num_consumers = 4;
+  SpmcRing<int> ring(16, num_consumers);
+  // Boost checks are not thread safe, the consumers count the barriers that passed their entry
+  std::vector<int> too_new(num_consumers, 0);
+  std::vector<int> out_of_order(num_consumers, 0);
+  std::vector<std::thread> consumers;
+  for (int c = 0; c < num_consumers; ++c) {
+    consumers.emplace_back([&ring, &too_new, &out_of_order, c]() {
+      int expected = 0;
+      while (expected < num_entries) {
+        int entry = 0;
+        if (!ring.try_read(c, entry)) {
+          std::this_thread::yield();
+          continue;
+        }
+        if (entry != expected) {
+          ++out_of_order[c];
+        }
+        // The consumers overtake each other, while this one holds its entry
+        for (int i = 0; i < (entry + c) % 3; ++i) {
+          std::this_thread::yield();
+        }
+        if (ring.oldest_pending_stamp() > static_cast<uint64_t>(entry)) { // NOLINT(build/unsigned)
+          ++too_new[c];
+        }
+        ++expected;
+        ring.advance(c);
+      }
+    });
+  }
+  for (int i = 0; i < num_entries;) {
+    if (ring.try_write(i, i)) {
+      ++i;
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  for (auto& consumer : consumers) {
+    consumer.join();
+  }
+  for (int c = 0; c < num_consumers; ++c) {
+    BOOST_REQUIRE_EQUAL(too_new[c], 0);
+    BOOST_REQUIRE_EQUAL(out_of_order[c], 0);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,5 +1,5 @@
 /**
- * @file VariableSizeElementQueue_test.cxx Unit Tests for the VariableSizeElementQueue
+ * @file VariableSizeElementQueue_test.cxx Unit Tests for the VariableSizeQueueModel
  *
  * This is part of the DUNE DAQ Application Framework, copyright 2020.
  * Licensing/copyright details are in the COPYING file that you should have
@@ -13,8 +13,8 @@
 
 #include "boost/test/unit_test.hpp"
 
-#include "readout/ReadoutTypes.hpp"
-#include "readout/utils/SearchableProducerConsumerQueue.hpp"
+#include "logging/Logging.hpp"
+#include "readout/models/VariableSizeQueueModel.hpp"
 
 #include <cstdio>
 #include <string>
@@ -24,150 +24,203 @@ using namespace dunedaq::readout;
 
 BOOST_AUTO_TEST_SUITE(VariableSizeElementQueue_test)
 
-struct KeyGetter
+/**
+ * @brief Element of which only the header and the first size bytes of the payload are relevant
+ * */
+struct VariableSizeElement
 {
-  uint32_t operator()(types::VariableSizePayloadWrapper& wrapper) // NOLINT(build/unsigned)
-  {
-    uint32_t timestamp;                                       // NOLINT(build/unsigned)
-    memcpy(&timestamp, wrapper.data.get(), sizeof(uint32_t)); // NOLINT(build/unsigned)
-    return timestamp;
-  }
+  uint64_t timestamp = 0; // NOLINT(build/unsigned)
+  uint64_t size = 0;      // NOLINT(build/unsigned)
+  char payload[1024];
+
+  uint64_t get_first_timestamp() const { return timestamp; } // NOLINT(build/unsigned)
+  void set_first_timestamp(uint64_t ts) { timestamp = ts; }  // NOLINT(build/unsigned)
+  size_t get_payload_size() { return 2 * sizeof(uint64_t) + size; } // NOLINT(build/unsigned)
 };
 
+// Largest stored element, including the alignment padding
+constexpr size_t max_stored_size = 2 * sizeof(uint64_t) + 256; // NOLINT(build/unsigned)
+
+using VariableSizeQueue = VariableSizeQueueModel<VariableSizeElement>;
+
+bool
+write_element(VariableSizeQueue& queue, uint32_t timestamp) // NOLINT(build/unsigned)
+{
+  VariableSizeElement element;
+  element.timestamp = timestamp;
+  element.size = timestamp % 256;
+  memset(element.payload, timestamp % 128, element.size);
+  return queue.write(std::move(element));
+}
+
+void
+check_element(VariableSizeQueue::Iterator& iter, uint32_t expected_timestamp) // NOLINT(build/unsigned)
+{
+  BOOST_REQUIRE(iter.good());
+  BOOST_REQUIRE_EQUAL((*iter).timestamp, expected_timestamp);
+  BOOST_REQUIRE_EQUAL((*iter).size, expected_timestamp % 256);
+  if ((*iter).size > 0) {
+    BOOST_REQUIRE_EQUAL((*iter).payload[(*iter).size - 1], static_cast<char>(expected_timestamp % 128));
+  }
+}
+
 BOOST_AUTO_TEST_CASE(VariableSizeElementQueue_find)
 {
   TLOG() << "Fill up a queue and check if the elements can be found" << std::endl;
-  SearchableProducerConsumerQueue<types::VariableSizePayloadWrapper, uint32_t, KeyGetter> // NOLINT(build/unsigned)
-    queue(10000);
+  VariableSizeQueue queue(10000, 10000 * max_stored_size);
   for (uint32_t timestamp_counter = 0; timestamp_counter < 10000; timestamp_counter += 10) { // NOLINT(build/unsigned)
-    char* payload = static_cast<char*>(malloc(1024));
-    memcpy(payload, &timestamp_counter, sizeof(uint32_t)); // NOLINT(build/unsigned)
-    types::VariableSizePayloadWrapper wrapper(1024, payload);
-    bool queue_write = queue.write(std::move(wrapper));
-    BOOST_REQUIRE(queue_write);
+    BOOST_REQUIRE(write_element(queue, timestamp_counter));
 
     for (uint32_t expected_timestamp = 0; expected_timestamp <= timestamp_counter; // NOLINT(build/unsigned)
          expected_timestamp += 10) {
-      uint32_t timestamp; // NOLINT(build/unsigned)
-      types::VariableSizePayloadWrapper* found_element = queue.find_element(expected_timestamp);
-      BOOST_REQUIRE(found_element);
-      std::memcpy(&timestamp, found_element->data.get(), sizeof(timestamp));
-      BOOST_REQUIRE_EQUAL(expected_timestamp, timestamp);
+      VariableSizeElement search_element;
+      search_element.set_first_timestamp(expected_timestamp);
+      auto iter = queue.lower_bound(search_element, false);
+      check_element(iter, expected_timestamp);
     }
   }
 }
 
-BOOST_AUTO_TEST_CASE(VariableSizeElementQueue_find_upper)
+BOOST_AUTO_TEST_CASE(VariableSizeElementQueue_find_covering)
 {
-  TLOG() << "Search for elements that are not in the queue" << std::endl;
-  SearchableProducerConsumerQueue<types::VariableSizePayloadWrapper, uint32_t, KeyGetter> // NOLINT(build/unsigned)
-    queue(10000);
+  TLOG() << "Search for timestamps between elements, the older element covers them" << std::endl;
+  VariableSizeQueue queue(10000, 10000 * max_stored_size);
   for (uint32_t timestamp_counter = 10; timestamp_counter < 10000; timestamp_counter += 10) { // NOLINT(build/unsigned)
-    char* payload = static_cast<char*>(malloc(1024));
-    memcpy(payload, &timestamp_counter, sizeof(uint32_t)); // NOLINT(build/unsigned)
-    types::VariableSizePayloadWrapper wrapper(1024, payload);
-    bool queue_write = queue.write(std::move(wrapper));
-    BOOST_REQUIRE(queue_write);
-
-    for (uint32_t expected_timestamp = 5; expected_timestamp <= timestamp_counter; // NOLINT(build/unsigned)
-         expected_timestamp += 10) {
-      uint32_t timestamp; // NOLINT(build/unsigned)
-      types::VariableSizePayloadWrapper* found_element = queue.find_element(expected_timestamp);
-      BOOST_REQUIRE(found_element);
-      std::memcpy(&timestamp, found_element->data.get(), sizeof(timestamp));
-      BOOST_REQUIRE_EQUAL(expected_timestamp + 5, timestamp);
+    BOOST_REQUIRE(write_element(queue, timestamp_counter));
+
+    for (uint32_t search_timestamp = 15; search_timestamp <= timestamp_counter + 5; // NOLINT(build/unsigned)
+         search_timestamp += 10) {
+      VariableSizeElement search_element;
+      search_element.set_first_timestamp(search_timestamp);
+      auto iter = queue.lower_bound(search_element, false);
+      check_element(iter, search_timestamp - 5);
     }
   }
 }
 
+BOOST_AUTO_TEST_CASE(VariableSizeElementQueue_find_straddling)
+{
+  TLOG() << "The element straddling a window begin is found, and the first of equal timestamps" << std::endl;
+  VariableSizeQueue queue(100, 100 * max_stored_size);
+  for (uint32_t timestamp : { 100, 200, 200, 200, 300 }) { // NOLINT(build/unsigned)
+    BOOST_REQUIRE(write_element(queue, timestamp));
+  }
+
+  VariableSizeElement search_element;
+  search_element.set_first_timestamp(150);
+  auto iter = queue.lower_bound(search_element, false);
+  check_element(iter, 100);
+  BOOST_REQUIRE_EQUAL(queue.elements_before(iter), 0);
+
+  search_element.set_first_timestamp(200);
+  auto first_equal_iter = queue.lower_bound(search_element, false);
+  check_element(first_equal_iter, 200);
+  BOOST_REQUIRE_EQUAL(queue.elements_before(first_equal_iter), 1);
+
+  search_element.set_first_timestamp(250);
+  auto last_equal_iter = queue.lower_bound(search_element, false);
+  check_element(last_equal_iter, 200);
+  BOOST_REQUIRE_EQUAL(queue.elements_before(last_equal_iter), 3);
+}
+
 BOOST_AUTO_TEST_CASE(VariableSizeElementQueue_find_outside)
 {
-  TLOG() << "Try to find elements that are bigger than the biggest one in the queue" << std::endl;
-  SearchableProducerConsumerQueue<types::VariableSizePayloadWrapper, uint32_t, KeyGetter> // NOLINT(build/unsigned)
-    queue(10);
-  char* payload = static_cast<char*>(malloc(1024));
-  uint32_t timestamp = 42;                       // NOLINT(build/unsigned)
-  memcpy(payload, &timestamp, sizeof(uint32_t)); // NOLINT(build/unsigned)
-  types::VariableSizePayloadWrapper wrapper(1024, payload);
-  bool queue_write = queue.write(std::move(wrapper));
-  BOOST_REQUIRE(queue_write);
-
-  types::VariableSizePayloadWrapper* found_element = queue.find_element(100);
-  BOOST_REQUIRE_EQUAL(found_element, nullptr);
+  TLOG() << "Try to find elements outside of the timestamps in the queue" << std::endl;
+  VariableSizeQueue queue(10, 10 * max_stored_size);
+  BOOST_REQUIRE(write_element(queue, 42));
+
+  VariableSizeElement search_element;
+  search_element.set_first_timestamp(100);
+  auto iter = queue.lower_bound(search_element, false);
+  check_element(iter, 42);
+
+  search_element.set_first_timestamp(10);
+  BOOST_REQUIRE(queue.lower_bound(search_element, false) == queue.end());
 }
 
 BOOST_AUTO_TEST_CASE(VariableSizeElementQueue_overrun)
 {
   TLOG() << "Cause an overrun of the cyclic buffer" << std::endl;
-  SearchableProducerConsumerQueue<types::VariableSizePayloadWrapper, uint32_t, KeyGetter> // NOLINT(build/unsigned)
-    queue(1001);
+  VariableSizeQueue queue(1001, 1001 * max_stored_size);
   for (uint32_t timestamp_counter = 0; timestamp_counter < 1000; ++timestamp_counter) { // NOLINT(build/unsigned)
-    char* payload = static_cast<char*>(malloc(1024));
-    memcpy(payload, &timestamp_counter, sizeof(uint32_t)); // NOLINT(build/unsigned)
-    types::VariableSizePayloadWrapper wrapper(1024, payload);
-    bool queue_write = queue.write(std::move(wrapper));
-    BOOST_REQUIRE(queue_write);
+    BOOST_REQUIRE(write_element(queue, timestamp_counter));
   }
 
-  for (int i = 0; i < 500; ++i) {
-    types::VariableSizePayloadWrapper wrapper;
-    bool read_successful = queue.read(wrapper);
-    BOOST_REQUIRE(read_successful);
+  for (uint32_t expected_timestamp = 0; expected_timestamp < 500; ++expected_timestamp) { // NOLINT(build/unsigned)
+    VariableSizeElement element;
+    BOOST_REQUIRE(queue.read(element));
+    BOOST_REQUIRE_EQUAL(element.timestamp, expected_timestamp);
   }
 
   for (uint32_t timestamp_counter = 1000; timestamp_counter < 1500; ++timestamp_counter) { // NOLINT(build/unsigned)
-    char* payload = static_cast<char*>(malloc(1024));
-    memcpy(payload, &timestamp_counter, sizeof(uint32_t)); // NOLINT(build/unsigned)
-    types::VariableSizePayloadWrapper wrapper(1024, payload);
-    bool queue_write = queue.write(std::move(wrapper));
-    BOOST_REQUIRE(queue_write);
+    BOOST_REQUIRE(write_element(queue, timestamp_counter));
   }
+  BOOST_REQUIRE_EQUAL(queue.occupancy(), 1000);
 
   for (uint32_t expected_timestamp = 500; expected_timestamp < 1500; ++expected_timestamp) { // NOLINT(build/unsigned)
-    uint32_t timestamp;                                                                      // NOLINT(build/unsigned)
-    types::VariableSizePayloadWrapper* found_element = queue.find_element(expected_timestamp);
-    BOOST_REQUIRE(found_element);
-    std::memcpy(&timestamp, found_element->data.get(), sizeof(timestamp));
-    BOOST_REQUIRE_EQUAL(expected_timestamp, timestamp);
+    VariableSizeElement search_element;
+    search_element.set_first_timestamp(expected_timestamp);
+    auto iter = queue.lower_bound(search_element, false);
+    check_element(iter, expected_timestamp);
   }
 }
 
-BOOST_AUTO_TEST_CASE(VariableSizeElementQueue_overrun_find_upper)
+BOOST_AUTO_TEST_CASE(VariableSizeElementQueue_overrun_find_covering)
 {
-  TLOG() << "Cause an overrun of the cyclic buffer and search for upper timestamps" << std::endl;
-  SearchableProducerConsumerQueue<types::VariableSizePayloadWrapper, uint32_t, KeyGetter> // NOLINT(build/unsigned)
-    queue(1001);
+  TLOG() << "Cause an overrun of the cyclic buffer and search between timestamps" << std::endl;
+  VariableSizeQueue queue(1001, 1001 * max_stored_size);
   for (uint32_t timestamp_counter = 10; timestamp_counter < 10000; timestamp_counter += 10) { // NOLINT(build/unsigned)
-    char* payload = static_cast<char*>(malloc(1024));
-    memcpy(payload, &timestamp_counter, sizeof(uint32_t)); // NOLINT(build/unsigned)
-    types::VariableSizePayloadWrapper wrapper(1024, payload);
-    bool queue_write = queue.write(std::move(wrapper));
-    BOOST_REQUIRE(queue_write);
+    BOOST_REQUIRE(write_element(queue, timestamp_counter));
   }
 
-  for (int i = 0; i < 500; ++i) {
-    types::VariableSizePayloadWrapper wrapper;
-    bool read_successful = queue.read(wrapper);
-    BOOST_REQUIRE(read_successful);
-  }
+  queue.pop(500);
 
   for (uint32_t timestamp_counter = 10000; timestamp_counter < 15000; // NOLINT(build/unsigned)
        timestamp_counter += 10) {
-    char* payload = static_cast<char*>(malloc(1024));
-    memcpy(payload, &timestamp_counter, sizeof(uint32_t)); // NOLINT(build/unsigned)
-    types::VariableSizePayloadWrapper wrapper(1024, payload);
-    bool queue_write = queue.write(std::move(wrapper));
-    BOOST_REQUIRE(queue_write);
+    BOOST_REQUIRE(write_element(queue, timestamp_counter));
+  }
+
+  for (uint32_t search_timestamp = 5015; search_timestamp < 14995; // NOLINT(build/unsigned)
+       search_timestamp += 10) {
+    VariableSizeElement search_element;
+    search_element.set_first_timestamp(search_timestamp);
+    auto iter = queue.lower_bound(search_element, false);
+    check_element(iter, search_timestamp - 5);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(VariableSizeElementQueue_full)
+{
+  TLOG() << "Check that a full byte ring refuses elements" << std::endl;
+  VariableSizeQueue queue(1000, 10 * max_stored_size);
+  uint32_t written = 0; // NOLINT(build/unsigned)
+  while (write_element(queue, 255 + written * 256)) {
+    ++written;
   }
+  BOOST_REQUIRE_EQUAL(written, 10);
+  queue.pop(1);
+  BOOST_REQUIRE(write_element(queue, 255 + written * 256));
+}
 
-  for (uint32_t expected_timestamp = 5005; expected_timestamp < 14995; // NOLINT(build/unsigned)
-       expected_timestamp += 10) {
-    uint32_t timestamp; // NOLINT(build/unsigned)
-    types::VariableSizePayloadWrapper* found_element = queue.find_element(expected_timestamp);
-    BOOST_REQUIRE(found_element);
-    std::memcpy(&timestamp, found_element->data.get(), sizeof(timestamp));
-    BOOST_REQUIRE_EQUAL(expected_timestamp + 5, timestamp);
+BOOST_AUTO_TEST_CASE(VariableSizeElementQueue_elements_before)
+{
+  TLOG() << "Count the elements older than a search result" << std::endl;
+  VariableSizeQueue queue(100, 100 * max_stored_size);
+  for (uint32_t timestamp_counter = 0; timestamp_counter < 500; timestamp_counter += 10) { // NOLINT(build/unsigned)
+    BOOST_REQUIRE(write_element(queue, timestamp_counter));
   }
+
+  VariableSizeElement search_element;
+  search_element.set_first_timestamp(250);
+  auto iter = queue.lower_bound(search_element, false);
+  BOOST_REQUIRE_EQUAL(queue.elements_before(iter), 25);
+
+  queue.pop(10);
+  auto iter_after_pop = queue.lower_bound(search_element, false);
+  BOOST_REQUIRE_EQUAL(queue.elements_before(iter_after_pop), 15);
+
+  auto end = queue.end();
+  BOOST_REQUIRE_EQUAL(queue.elements_before(end), queue.occupancy());
 }
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,93 @@
+/**
+ * @file WorkStealingExecutor_test.cxx Unit Tests for the WorkStealingExecutor
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+/**
+ * @brief Name of this test module
+ */
+#define BOOST_TEST_MODULE WorkStealingExecutor_test // NOLINT
+
+#include "boost/test/unit_test.hpp"
+
+#include "logging/Logging.hpp"
+#include "readout/utils/SpmcRing.hpp"
+#include "readout/utils/WorkStealingExecutor.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq::readout;
+
+BOOST_AUTO_TEST_SUITE(WorkStealingExecutor_test)
+
+BOOST_AUTO_TEST_CASE(WorkStealingExecutor_strand_order)
+{
+  TLOG() << "Every strand sees its work in order, while the strands share the pool" << std::endl;
+  constexpr int num_strands = 6;
+  constexpr int num_items = 20000;
+
+  WorkStealingExecutor executor;
+  BOOST_REQUIRE(executor.start(3, {}));
+  BOOST_REQUIRE(executor.start(3, {}));
+  BOOST_REQUIRE(!executor.start(4, {}));
+
+  struct Link
+  {
+    std::unique_ptr<SpmcRing<int>> ring = std::make_unique<SpmcRing<int>>(1024, 1);
+    std::unique_ptr<WorkStealingExecutor::Strand> strand;
+    int expected = 0;
+    int out_of_order = 0;
+    std::atomic<bool> running{ false };
+    int overlaps = 0;
+  };
+  std::vector<Link> links(num_strands);
+  for (auto& link : links) {
+    link.strand = executor.make_strand([&link]() {
+      if (link.running.exchange(true)) {
+        ++link.overlaps;
+      }
+      int item = 0;
+      for (int i = 0; i < 8 && link.ring->try_read(0, item); ++i) {
+        if (item != link.expected) {
+          ++link.out_of_order;
+        }
+        link.expected = item + 1;
+        link.ring->advance(0);
+      }
+      link.running.store(false);
+      return !link.ring->empty(0);
+    });
+  }
+
+  std::vector<std::thread> producers;
+  for (auto& link : links) {
+    producers.emplace_back([&link]() {
+      for (int i = 0; i < num_items; ++i) {
+        while (!link.ring->try_write(i, i)) {
+          std::this_thread::yield();
+        }
+        link.strand->notify();
+      }
+    });
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+  for (auto& link : links) {
+    while (!link.ring->empty(0) || !link.strand->idle()) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    BOOST_REQUIRE_EQUAL(link.expected, num_items);
+    BOOST_REQUIRE_EQUAL(link.out_of_order, 0);
+    BOOST_REQUIRE_EQUAL(link.overlaps, 0);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()